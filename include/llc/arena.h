@@ -0,0 +1,98 @@
+#ifndef LLC_ARENA_H
+#define LLC_ARENA_H
+
+#include <llc/defines.h>
+
+#include <cstddef>
+#include <vector>
+
+namespace llc {
+
+// memory for what a running program keeps making and dropping: boxed objects, argument lists and
+// operand stacks. a thread keeps the blocks it frees and hands them out again, so once a loop or
+// a recursion has run a few times it no longer reaches malloc. blocks are returned to the system
+// by trim() and when the thread exits
+struct Arena {
+    // counters of the calling thread, see Program::last_run_arena
+    struct Stats {
+        Stats operator-(const Stats& rhs) const {
+            return {allocations - rhs.allocations, reused - rhs.reused, bytes - rhs.bytes,
+                    leases - rhs.leases, leases_reused - rhs.leases_reused};
+        }
+
+        // blocks handed out, and how many of them were recycled instead of allocated
+        size_t allocations = 0;
+        size_t reused = 0;
+        size_t bytes = 0;
+        // scratch vectors taken, and how many of them already had storage
+        size_t leases = 0;
+        size_t leases_reused = 0;
+    };
+
+    static void* allocate(size_t size);
+    static void deallocate(void* ptr, size_t size);
+    static void trim();
+
+    static Stats& stats();
+};
+
+// lets standard containers take their storage from the arena
+template <typename T>
+struct ArenaAllocator {
+    using value_type = T;
+
+    ArenaAllocator() = default;
+    template <typename U>
+    ArenaAllocator(const ArenaAllocator<U>&) {
+    }
+
+    T* allocate(size_t n) {
+        return static_cast<T*>(Arena::allocate(n * sizeof(T)));
+    }
+    void deallocate(T* ptr, size_t n) {
+        Arena::deallocate(ptr, n * sizeof(T));
+    }
+
+    template <typename U>
+    bool operator==(const ArenaAllocator<U>&) const {
+        return true;
+    }
+    template <typename U>
+    bool operator!=(const ArenaAllocator<U>&) const {
+        return false;
+    }
+};
+
+// a vector borrowed from the calling thread for the duration of a call: it is given back emptied
+// but with its storage when the scope ends, so the next call of the same depth reuses it
+template <typename T>
+struct ScratchVector {
+    ScratchVector() {
+        auto& free = pool();
+        Arena::stats().leases++;
+        if (!free.empty()) {
+            values.swap(free.back());
+            free.pop_back();
+            if (values.capacity())
+                Arena::stats().leases_reused++;
+        }
+    }
+    ~ScratchVector() {
+        values.clear();
+        pool().push_back(std::move(values));
+    }
+    ScratchVector(const ScratchVector&) = delete;
+    ScratchVector& operator=(const ScratchVector&) = delete;
+
+    std::vector<T> values;
+
+  private:
+    static std::vector<std::vector<T>>& pool() {
+        static thread_local std::vector<std::vector<T>> free;
+        return free;
+    }
+};
+
+}  // namespace llc
+
+#endif  // LLC_ARENA_H
@@ -0,0 +1,55 @@
+#ifndef LLC_CLOSURE_H
+#define LLC_CLOSURE_H
+
+#include <llc/defines.h>
+#include <llc/types.h>
+
+#include <functional>
+
+namespace llc {
+
+using Evaluator = std::function<Object()>;
+using Predicate = std::function<bool()>;
+using Action = std::function<Flow(std::optional<Object>& result)>;
+
+struct ClosureBody : Statement {
+    Completion run(const Scope& scope) const override;
+
+    Action action;
+};
+
+struct ClosureCompiler {
+    void compile(std::shared_ptr<Scope> scope);
+
+  private:
+    // a value operand, either computed by "evaluate" or, for variables and literals, readable
+    // in place through "place" without making a copy first
+    struct Value {
+        Value(Evaluator evaluate, VariableRef place = {},
+              std::shared_ptr<Object> constant = nullptr)
+            : evaluate(evaluate), place(place), constant(constant){};
+
+        Evaluator evaluate;
+        VariableRef place;
+        std::shared_ptr<Object> constant;
+    };
+
+    Action compile_scope(const Scope& scope);
+    Action compile_statement(const std::shared_ptr<Statement>& statement, const Scope& scope);
+    std::function<void()> compile_effect(const Expression& expression, const Scope& scope);
+    std::function<void()> compile_effect(const std::shared_ptr<Operand>& operand,
+                                         const Scope& scope);
+    Predicate compile_condition(const Expression& expression, const Scope& scope);
+    Predicate compile_condition(const std::shared_ptr<Operand>& operand, const Scope& scope);
+
+    Value compile_operand(const std::shared_ptr<Operand>& operand, const Scope& scope);
+    Value compile_fallback(const std::shared_ptr<Operand>& operand, const Scope& scope);
+    Value compile_call(const FunctionCall& call, const Scope& scope);
+    VariableRef resolve_variable(const std::shared_ptr<Operand>& operand, const Scope& scope);
+
+    int loop_depth = 0;
+};
+
+}  // namespace llc
+
+#endif  // LLC_CLOSURE_H
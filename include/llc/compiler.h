@@ -3,19 +3,48 @@
 
 #include <llc/tokenizer.h>
 #include <llc/parser.h>
+#include <llc/vm.h>
+#include <llc/closure.h>
+#include <llc/jit.h>
+#include <llc/optimizer.h>
+#include <llc/ir.h>
 
 namespace llc {
 
+enum class Engine { TreeWalker, Bytecode, Closure };
+
 struct Compiler {
     void compile(Program& program) {
         try {
             auto tokens = tokenizer.tokenize(program);
             parser.parse(program, tokens);
+            passes.run(program.scope);
+            if (jit)
+                JitCompiler().compile(program.scope);
+            if (engine == Engine::Bytecode)
+                BytecodeCompiler().compile(program.scope);
+            else if (engine == Engine::Closure)
+                ClosureCompiler().compile(program.scope);
         } catch (const Exception& exception) {
             throw_exception(exception(program.source));
         }
     }
 
+    // the internal functions of a compiled program in SSA form, optimized by "ir_passes", see ir.h
+    std::vector<ir::Function> lower(const Program& program) const {
+        auto functions = ir::build(program.scope.get());
+        for (auto& function : functions)
+            ir_passes.run(function);
+        return functions;
+    }
+
+    Engine engine = Engine::TreeWalker;
+    // run numeric functions as native code where possible, see jit.h
+    bool jit = true;
+    // rewrites of the program run before it is lowered, see optimizer.h
+    PassManager passes;
+    ir::PassManager ir_passes;
+
   private:
     Tokenizer tokenizer;
     Parser parser;
@@ -23,4 +52,4 @@ struct Compiler {
 
 }  // namespace llc
 
-#endif  // LLC_COMPILER_H
\ No newline at end of file
+#endif  // LLC_COMPILER_H
@@ -1,4 +1,8 @@
 #ifndef LLC_DEFINES_H
 #define LLC_DEFINES_H
 
-#endif  // LLC_DEFINES_H
\ No newline at end of file
+#if defined(__x86_64__) && (defined(__linux__) || defined(__APPLE__))
+#define LLC_JIT_SUPPORTED
+#endif
+
+#endif  // LLC_DEFINES_H
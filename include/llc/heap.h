@@ -0,0 +1,78 @@
+#ifndef LLC_HEAP_H
+#define LLC_HEAP_H
+
+#include <llc/defines.h>
+
+#include <cstddef>
+#include <memory>
+#include <mutex>
+#include <new>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace llc {
+
+// the memory behind "new" in a program. values are placed one after another in large chunks and
+// are never freed one by one: release() destroys all of them at once and keeps the chunks for the
+// next run, so a program that is run again reuses the memory of its previous run instead of
+// leaking it. every Program owns one, code running outside of a program uses a shared one
+struct Heap {
+    struct Stats {
+        // bytes and values handed out since the last release()
+        size_t live_bytes = 0;
+        size_t allocations = 0;
+        // bytes taken from the system, chunks included
+        size_t reserved_bytes = 0;
+    };
+
+    Heap() = default;
+    ~Heap();
+    Heap(const Heap&) = delete;
+    Heap& operator=(const Heap&) = delete;
+
+    template <typename T, typename... Args>
+    T* make(Args&&... args) {
+        void* memory = allocate(sizeof(T), alignof(T));
+        T* object = new (memory) T(std::forward<Args>(args)...);
+        if constexpr (!std::is_trivially_destructible_v<T>)
+            finalize(object, [](void* ptr) { static_cast<T*>(ptr)->~T(); });
+        return object;
+    }
+
+    void* allocate(size_t size, size_t alignment);
+    void release();
+
+    Stats stats() const;
+
+    // the heap "new" allocates from on the calling thread
+    static Heap& current();
+
+    // makes a heap current for the calling thread until the end of the scope
+    struct Use {
+        Use(Heap& heap);
+        ~Use();
+
+        Heap* previous;
+    };
+
+  private:
+    struct Finalizer {
+        void (*destroy)(void*);
+        void* object;
+    };
+
+    void finalize(void* object, void (*destroy)(void*));
+
+    mutable std::mutex mutex;
+    std::vector<char*> chunks;
+    size_t chunk = 0;
+    size_t offset = 0;
+    std::vector<std::pair<void*, size_t>> large;
+    std::vector<Finalizer> finalizers;
+    Stats counters;
+};
+
+}  // namespace llc
+
+#endif  // LLC_HEAP_H
@@ -0,0 +1,188 @@
+#ifndef LLC_IR_H
+#define LLC_IR_H
+
+#include <llc/defines.h>
+#include <llc/types.h>
+
+#include <memory>
+#include <optional>
+#include <string>
+#include <vector>
+
+namespace llc {
+
+// internal functions in static single assignment form, for analyses and backends that need
+// explicit control flow and values instead of the operand trees the engines run. a function is a
+// graph of basic blocks, each a list of instructions ended by a jump, a branch or a return. every
+// instruction defines one value, named by its index in Function::values, and the values a variable
+// has along several paths meet in the phi instructions at the start of a block. functions whose
+// variables are all bool, char, int, int64_t, float or double locals are lowered, others are not
+namespace ir {
+
+enum class Op : uint8_t {
+    Constant,
+    Parameter,
+    Copy,
+    Phi,
+    Convert,
+    Add,
+    Sub,
+    Mul,
+    Div,
+    Neg,
+    LessThan,
+    LessEqual,
+    GreaterThan,
+    GreaterEqual,
+    Equal,
+    NotEqual,
+    Call
+};
+
+struct Instruction {
+    Op op = Op::Constant;
+    // the type id of the value, typeid_unknown for calls without result
+    size_t type = typeid_unknown;
+    // the operands of a phi are in the order of the predecessors of its block
+    std::vector<int> operands;
+    // the value of a constant and the index of a parameter
+    Object constant;
+    int index = -1;
+    // the callee of a call and the name it is called by
+    const llc::Function* function = nullptr;
+    std::string name;
+    // the block holding the instruction, -1 once it is removed
+    int block = -1;
+};
+
+enum class Exit : uint8_t { Jump, Branch, Return };
+
+struct Block {
+    std::vector<int> successors() const;
+
+    // phis come first
+    std::vector<int> instructions;
+    std::vector<int> predecessors;
+    // a jump goes to targets[0], a branch to targets[0] when "condition" holds and to targets[1]
+    // otherwise. a return returns "value", or nothing when it is -1
+    Exit exit = Exit::Return;
+    int condition = -1;
+    int targets[2] = {-1, -1};
+    int value = -1;
+    bool removed = false;
+};
+
+struct Function {
+    // replaces every use of "value" by "by" and removes "value"
+    void replace(int value, int by);
+    void remove(int value);
+    // removes the edge from block "from" to block "to" and the matching operand of its phis
+    void remove_edge(int from, int to);
+    // removes a block and its edges
+    void remove_block(int block);
+    bool is_phi(int value) const {
+        return values[value].op == Op::Phi;
+    }
+
+    std::string name;
+    std::vector<size_t> parameters;
+    size_t return_type = typeid_unknown;
+    std::vector<Instruction> values;
+    // blocks[0] is the entry
+    std::vector<Block> blocks;
+    // the definition of the function, which calls are run from
+    const Scope* scope = nullptr;
+};
+
+// lowers "function", returns nullopt when it uses something the IR does not represent
+std::optional<Function> build(const std::string& name, const InternalFunction& function);
+// lowers every internal function reachable from "scope" that can be lowered
+std::vector<Function> build(Scope* scope);
+
+// a listing of "function" with one instruction per line, for debugging
+std::string print(const Function& function);
+
+// the value an instruction computes from the values of its operands, nullopt when it cannot be
+// known ahead of running it: parameters, phis, calls and integer divisions by zero
+std::optional<Object> evaluate(const Instruction& instruction,
+                               const std::vector<Object>& operands);
+
+// runs "function" one instruction at a time, the reference behavior for passes and backends
+std::optional<Object> run(const Function& function, const std::vector<Object>& args);
+
+// the immediate dominator of every block, -1 for the entry and for removed blocks
+std::vector<int> dominators(const Function& function);
+
+struct Pass {
+    virtual ~Pass() = default;
+    virtual std::string name() const = 0;
+    virtual void run(Function& function) = 0;
+};
+
+// replaces copies, conversions to the type a value already has and phis whose operands are all
+// the same value by the value itself
+struct CopyPropagation : Pass {
+    std::string name() const override {
+        return "copy-propagation";
+    }
+    void run(Function& function) override;
+};
+
+// finds the values that are constant on every path that can be taken, following only the
+// branches whose condition is not known to be false. such values become constants, branches on
+// them become jumps and the blocks that cannot be reached are removed
+struct SparseConditionalConstantPropagation : Pass {
+    std::string name() const override {
+        return "sparse-conditional-constant-propagation";
+    }
+    void run(Function& function) override;
+};
+
+// replaces an instruction computing the same operation on the same operands as one of a block
+// dominating it by the value of that one
+struct GlobalValueNumbering : Pass {
+    std::string name() const override {
+        return "global-value-numbering";
+    }
+    void run(Function& function) override;
+};
+
+// removes the instructions whose value is not used by a call, a branch or a return and the
+// blocks that cannot be reached from the entry, and merges a block reached by a jump from its only
+// predecessor into it
+struct DeadCodeElimination : Pass {
+    std::string name() const override {
+        return "dead-code-elimination";
+    }
+    void run(Function& function) override;
+};
+
+// the passes run on each function, in order, see llc::PassManager
+struct PassManager {
+    PassManager();
+
+    void add(std::unique_ptr<Pass> pass);
+    void enable(const std::string& name, bool enabled = true);
+    void disable(const std::string& name) {
+        enable(name, false);
+    }
+    bool enabled(const std::string& name) const;
+
+    void run(Function& function) const;
+
+  private:
+    struct Entry {
+        std::unique_ptr<Pass> pass;
+        bool enabled = true;
+    };
+
+    Entry& find(const std::string& name);
+
+    std::vector<Entry> passes;
+};
+
+}  // namespace ir
+
+}  // namespace llc
+
+#endif  // LLC_IR_H
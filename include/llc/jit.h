@@ -0,0 +1,18 @@
+#ifndef LLC_JIT_H
+#define LLC_JIT_H
+
+#include <llc/defines.h>
+#include <llc/types.h>
+
+namespace llc {
+
+// translates internal functions whose parameters, locals and return value are all bool, int,
+// float or double to x86-64 machine code, calls to such a function then run natively while every
+// other function keeps being interpreted. does nothing on unsupported platforms
+struct JitCompiler {
+    void compile(std::shared_ptr<Scope> scope);
+};
+
+}  // namespace llc
+
+#endif  // LLC_JIT_H
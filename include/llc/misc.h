@@ -194,10 +194,16 @@ struct deferred_bool {
     static constexpr bool value = val;
 };
 
-template <typename... Args, typename T, typename R>
-auto overload_cast(R (T::*func)(Args...)) {
-    return func;
-}
+template <typename... Args>
+struct OverloadCast {
+    template <typename T, typename R>
+    constexpr auto operator()(R (T::*func)(Args...)) const {
+        return func;
+    }
+};
+
+template <typename... Args>
+constexpr OverloadCast<Args...> overload_cast = {};
 
 }  // namespace llc
 
@@ -0,0 +1,131 @@
+#ifndef LLC_OPTIMIZER_H
+#define LLC_OPTIMIZER_H
+
+#include <llc/defines.h>
+#include <llc/types.h>
+
+#include <functional>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace llc {
+
+// a rewrite of the parsed and resolved program, run by Compiler before an engine lowers it
+struct Pass {
+    virtual ~Pass() = default;
+    virtual std::string name() const = 0;
+    virtual void run(std::shared_ptr<Scope> scope) = 0;
+};
+
+// replaces operators whose operands are all literals by the literal they compute
+struct ConstantFolding : Pass {
+    std::string name() const override {
+        return "constant-folding";
+    }
+    void run(std::shared_ptr<Scope> scope) override;
+};
+
+// replaces reads of a variable by its value when its only assignment is "x = literal" in the
+// block declaring it and every read comes after that statement, so that feature flags such as
+// "int ENABLE_X = 0;" become literals. what becomes constant is folded
+struct ConstantPropagation : Pass {
+    std::string name() const override {
+        return "constant-propagation";
+    }
+    void run(std::shared_ptr<Scope> scope) override;
+};
+
+// removes the branches of if/else chains whose condition is a literal, the statements following a
+// return or a break, and loops that do not run or only update their own variables
+struct DeadCodeElimination : Pass {
+    std::string name() const override {
+        return "dead-code-elimination";
+    }
+    void run(std::shared_ptr<Scope> scope) override;
+};
+
+// moves computations of loops whose operands do not change while the loop runs into temporaries
+// assigned before it. calls are moved when they are to functions bound with bind_pure()
+struct LoopInvariantCodeMotion : Pass {
+    std::string name() const override {
+        return "loop-invariant-code-motion";
+    }
+    void run(std::shared_ptr<Scope> scope) override;
+};
+
+// replaces calls to small internal functions by their body with the arguments in place of the
+// parameters. a body is inlined when it is "return expression;", or a single expression for calls
+// whose result is not used, of at most "threshold" operators and operands, so that wrappers and
+// getters cost nothing. calls brought in by inlining are inlined in turn up to "depth" times and
+// functions calling themselves are not inlined. a threshold of 0 turns inlining off
+struct Inlining : Pass {
+    std::string name() const override {
+        return "inlining";
+    }
+    void run(std::shared_ptr<Scope> scope) override;
+
+    int threshold = 16;
+    int depth = 3;
+};
+
+// the passes Compiler runs, in order. each can be turned off by name to measure what it brings
+struct PassManager {
+    PassManager();
+
+    void add(std::unique_ptr<Pass> pass);
+    void enable(const std::string& name, bool enabled = true);
+    void disable(const std::string& name) {
+        enable(name, false);
+    }
+    bool enabled(const std::string& name) const;
+    // the pass of type T, to change its parameters
+    template <typename T>
+    T& get() {
+        T* found = nullptr;
+        for (auto& entry : passes)
+            if (found == nullptr)
+                found = dynamic_cast<T*>(entry.pass.get());
+        if (found == nullptr)
+            throw_exception("no optimization pass has the requested type");
+        return *found;
+    }
+
+    void run(std::shared_ptr<Scope> scope) const;
+
+  private:
+    struct Entry {
+        std::unique_ptr<Pass> pass;
+        bool enabled = true;
+    };
+
+    Entry& find(const std::string& name);
+
+    std::vector<Entry> passes;
+};
+
+// calls "visit" on every expression of "scope" and its nested blocks, with the scope the
+// expression is resolved against. function definitions are not entered
+void for_each_expression(Scope* scope, const std::function<void(Expression&, Scope&)>& visit);
+// the same for one statement of "scope"
+void for_each_expression(Statement* statement, Scope& scope,
+                         const std::function<void(Expression&, Scope&)>& visit);
+
+// the operands right below "operand", each with whether it is a place that may be modified: the
+// target of an assignment or an increment, the object of a method call, or the object of a
+// member or element that is itself modified. "written" tells the same of "operand"
+std::vector<std::pair<std::shared_ptr<Operand>*, bool>> children_of(Operand& operand,
+                                                                    bool written = false);
+
+// calls "visit" on "operand" and every operand below it, children first, see children_of
+void for_each_operand(std::shared_ptr<Operand>& operand,
+                      const std::function<void(std::shared_ptr<Operand>&, bool written)>& visit,
+                      bool written = false);
+
+// replaces operators of "operand" whose operands are literals by their result, returns whether
+// anything was replaced
+bool fold_constants(std::shared_ptr<Operand>& operand, const Scope& scope);
+
+}  // namespace llc
+
+#endif  // LLC_OPTIMIZER_H
@@ -23,10 +23,19 @@ struct Parser {
         for (const auto& type : program.types)
             program.scope->types[type.first] = type.second;
         for (const auto& var : program.variables)
-            program.scope->variables[var.first] = var.second;
+            program.scope->add_variable(var.first, var.second);
         for (const auto& function : program.functions)
             program.scope->functions[function.first] = function.second;
         parse_recursively(program.scope);
+
+        // every declaration is known now, lay out the frames of functions and bind variable
+        // references to their storage
+        auto entries = collect_entry_scopes(program.scope.get());
+        for (Scope* scope : entries)
+            if (scope->function)
+                scope->allocate_frame();
+        for (Scope* scope : entries)
+            scope->resolve(*scope);
     }
 
   private:
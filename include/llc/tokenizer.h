@@ -14,7 +14,7 @@ struct Tokenizer {
     void putback();
 
     void skip();
-    float scan_value(char c);
+    Object scan_value(char c);
     std::string scan_string(char c);
 
     const char* text = nullptr;
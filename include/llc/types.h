@@ -3,7 +3,12 @@
 
 #include <llc/defines.h>
 #include <llc/misc.h>
+#include <llc/arena.h>
+#include <llc/heap.h>
 
+#include <array>
+#include <atomic>
+#include <functional>
 #include <optional>
 #include <string>
 #include <memory>
@@ -58,55 +63,138 @@ inline uint64_t operator&(TokenType a, TokenType b) {
 
 std::string enum_to_string(TokenType type);
 
-struct Token {
-    TokenType type = TokenType::Invalid;
-    Location location;
-
-    float value;
-    char value_c;
-    std::string value_s;
-    std::string id;
-};
-
 struct Scope;
+struct Frame;
+struct BaseObject;
 struct Expression;
 
-extern std::unordered_map<size_t, std::string> type_id_to_name;
+// every type is identified by a small dense id. the arithmetic types own the first ids, in the
+// order of ArithmeticTypes, so that converting between them is a lookup in a table. the other
+// types get the next free id the first time they are used
+using ArithmeticTypes = std::tuple<bool, char, signed char, unsigned char, short, unsigned short,
+                                   int, unsigned int, long, unsigned long, long long,
+                                   unsigned long long, float, double>;
+static constexpr size_t num_arithmetic_types = std::tuple_size_v<ArithmeticTypes>;
+
+template <typename T, size_t index = 0>
+constexpr size_t arithmetic_type_index() {
+    if constexpr (index == num_arithmetic_types)
+        return index;
+    else if constexpr (std::is_same_v<T, std::tuple_element_t<index, ArithmeticTypes>>)
+        return index;
+    else
+        return arithmetic_type_index<T, index + 1>();
+}
+
+size_t new_type_id(std::string name = "");
+void set_type_name(size_t type_id, std::string name);
+// an empty string for types that were never named
+std::string find_type_name(size_t type_id);
+
+template <typename T>
+size_t type_id_of() {
+    using Ty = std::decay_t<T>;
+    if constexpr (arithmetic_type_index<Ty>() != num_arithmetic_types) {
+        return arithmetic_type_index<Ty>();
+    } else {
+        static const size_t type_id = new_type_id();
+        return type_id;
+    }
+}
 
 template <typename T>
 std::string get_type_name() {
     using Ty = std::decay_t<T>;
-    auto it = type_id_to_name.find(typeid(Ty).hash_code());
-    if (it == type_id_to_name.end())
+    std::string name = find_type_name(type_id_of<Ty>());
+    if (name.empty())
         throw_exception("cannot get name of unregistered type T, typeid(T).name(): \"",
                         typeid(Ty).name(), '"');
-    return it->second;
+    return name;
 }
 
 inline std::string get_type_name(size_t type_id) {
-    auto it = type_id_to_name.find(type_id);
-    if (it == type_id_to_name.end())
+    std::string name = find_type_name(type_id);
+    if (name.empty())
         throw_exception("cannot get name of unregistered type T");
-    return it->second;
+    return name;
+}
+
+template <typename T>
+void set_type_name(std::string name) {
+    set_type_name(type_id_of<T>(), name);
 }
 
-static const size_t typeid_bool = typeid(bool).hash_code();
-static const size_t typeid_int = typeid(int).hash_code();
-static const size_t typeid_char = typeid(char).hash_code();
-static const size_t typeid_float = typeid(float).hash_code();
-static const size_t typeid_double = typeid(double).hash_code();
-static const size_t typeid_size_t = typeid(size_t).hash_code();
+static constexpr size_t typeid_bool = arithmetic_type_index<bool>();
+static constexpr size_t typeid_int = arithmetic_type_index<int>();
+static constexpr size_t typeid_char = arithmetic_type_index<char>();
+static constexpr size_t typeid_int64 = arithmetic_type_index<int64_t>();
+static constexpr size_t typeid_float = arithmetic_type_index<float>();
+static constexpr size_t typeid_double = arithmetic_type_index<double>();
+static constexpr size_t typeid_size_t = arithmetic_type_index<size_t>();
+// the type of an expression that is only known when it is evaluated
+static constexpr size_t typeid_unknown = size_t(-1);
+
+// converts the arithmetic value at "from" to the one at "to", indexed by their type ids
+using Conversion = void (*)(const void* from, void* to);
+
+template <typename From, typename To>
+void convert_arithmetic(const void* from, void* to) {
+    *(To*)to = To(*(const From*)from);
+}
+
+template <typename... Ts>
+constexpr auto make_conversion_table(std::tuple<Ts...>*) {
+    using Row = std::array<Conversion, sizeof...(Ts)>;
+    auto row = [](auto* from) {
+        return Row{&convert_arithmetic<std::remove_pointer_t<decltype(from)>, Ts>...};
+    };
+    return std::array<Row, sizeof...(Ts)>{row((Ts*)nullptr)...};
+}
+
+static constexpr auto arithmetic_conversions = make_conversion_table((ArithmeticTypes*)nullptr);
 
 struct Object;
 struct Function;
 
-struct BreakLoop {};
+// deep copies of objects and functions made by the calling thread, to measure how many copies a
+// program or an engine makes, see Program::last_run_clones
+struct CloneCounter {
+    static inline thread_local size_t objects = 0;
+    static inline thread_local size_t functions = 0;
+
+    static size_t total() {
+        return objects + functions;
+    }
+    static void reset() {
+        objects = functions = 0;
+    }
+};
 
 struct BaseFunction {
     virtual ~BaseFunction() = default;
     virtual BaseFunction* clone() const = 0;
     virtual std::optional<Object> run(const Scope& scope,
                                       const std::vector<Expression>& exprs) const = 0;
+    virtual std::optional<Object> call(const Scope& scope,
+                                       const std::vector<Object>& args) const = 0;
+    // runs the function as a method of "self", functions bound to their object ignore it
+    virtual std::optional<Object> run_method(const Scope& scope,
+                                             const std::vector<Expression>& exprs,
+                                             BaseObject* self) const;
+    // the type of the returned object when the function returns one
+    virtual size_t return_type_id() const {
+        return typeid_unknown;
+    }
+
+    // set for host functions bound with bind_pure(): their result only depends on their arguments
+    // and their object, and they change neither, so that calls can be moved out of loops
+    bool pure = false;
+};
+
+// machine code generated for an InternalFunction, see jit.h
+struct NativeFunction {
+    virtual ~NativeFunction() = default;
+    virtual std::optional<Object> call(const std::vector<Object>& args) const = 0;
 };
 
 struct BaseObject {
@@ -115,47 +203,49 @@ struct BaseObject {
     virtual ~BaseObject() = default;
     virtual BaseObject* clone() const = 0;
 
+    // boxed values are made and dropped by almost every operation, they come from the arena
+    static void* operator new(size_t size) {
+        return Arena::allocate(size);
+    }
+    static void operator delete(void* ptr, size_t size) {
+        Arena::deallocate(ptr, size);
+    }
+
     virtual BaseObject* alloc() const = 0;
     virtual Object construct(const std::vector<Object>& objects) const = 0;
 
     virtual void* ptr() const = 0;
-    virtual void assign(const BaseObject* rhs) = 0;
-    virtual void add(BaseObject* rhs) = 0;
-    virtual void sub(BaseObject* rhs) = 0;
-    virtual void mul(BaseObject* rhs) = 0;
-    virtual void div(BaseObject* rhs) = 0;
+    virtual void assign(const Object& rhs) = 0;
+    virtual void add(const Object& rhs) = 0;
+    virtual void sub(const Object& rhs) = 0;
+    virtual void mul(const Object& rhs) = 0;
+    virtual void div(const Object& rhs) = 0;
     virtual Object neg() const = 0;
     virtual void increment() = 0;
     virtual void decrement() = 0;
-    virtual bool less_than(BaseObject* rhs) const = 0;
-    virtual bool less_equal(BaseObject* rhs) const = 0;
-    virtual bool greater_than(BaseObject* rhs) const = 0;
-    virtual bool greater_equal(BaseObject* rhs) const = 0;
-    virtual bool equal(BaseObject* rhs) const = 0;
-    virtual bool not_equal(BaseObject* rhs) const = 0;
+    virtual bool less_than(const Object& rhs) const = 0;
+    virtual bool less_equal(const Object& rhs) const = 0;
+    virtual bool greater_than(const Object& rhs) const = 0;
+    virtual bool greater_equal(const Object& rhs) const = 0;
+    virtual bool equal(const Object& rhs) const = 0;
+    virtual bool not_equal(const Object& rhs) const = 0;
 
     virtual Object get_element(size_t index) const = 0;
     virtual void set_element(size_t index, Object object) = 0;
 
+    // arithmetic values convert to any arithmetic type, other types and references must match
     template <typename T>
     T as() const {
         using Ty = std::decay_t<T>;
 
-        if constexpr (std::is_fundamental<Ty>::value) {
-            if (type_id() == typeid_bool)
-                return T(*(bool*)ptr());
-            else if (type_id() == typeid_int)
-                return T(*(int*)ptr());
-            else if (type_id() == typeid_char)
-                return T(*(char*)ptr());
-            else if (type_id() == typeid_float)
-                return T(*(float*)ptr());
-            else if (type_id() == typeid_double)
-                return T(*(double*)ptr());
-            else if (type_id() == typeid_size_t)
-                return T(*(size_t*)ptr());
+        if constexpr (std::is_arithmetic_v<Ty> && !std::is_reference_v<T>) {
+            if (type_id() < num_arithmetic_types) {
+                Ty value;
+                arithmetic_conversions[type_id()][type_id_of<Ty>()](ptr(), &value);
+                return value;
+            }
         }
-        if (type_id() != typeid(Ty).hash_code())
+        if (type_id() != type_id_of<Ty>())
             throw_exception("cannot convert type \"", type_name(), "\" to type \"",
                             get_type_name<Ty>(), '"');
 
@@ -166,21 +256,14 @@ struct BaseObject {
     std::optional<T> as_opt() const {
         using Ty = std::decay_t<T>;
 
-        if constexpr (std::is_fundamental<Ty>::value) {
-            if (type_id() == typeid_bool)
-                return T(*(bool*)ptr());
-            else if (type_id() == typeid_int)
-                return T(*(int*)ptr());
-            else if (type_id() == typeid_char)
-                return T(*(char*)ptr());
-            else if (type_id() == typeid_float)
-                return T(*(float*)ptr());
-            else if (type_id() == typeid_double)
-                return T(*(double*)ptr());
-            else if (type_id() == typeid_size_t)
-                return T(*(size_t*)ptr());
+        if constexpr (std::is_arithmetic_v<Ty>) {
+            if (type_id() < num_arithmetic_types) {
+                Ty value;
+                arithmetic_conversions[type_id()][type_id_of<Ty>()](ptr(), &value);
+                return value;
+            }
         }
-        if (type_id() != typeid(Ty).hash_code())
+        if (type_id() != type_id_of<Ty>())
             return std::nullopt;
 
         return *(Ty*)ptr();
@@ -190,27 +273,27 @@ struct BaseObject {
     std::optional<std::reference_wrapper<std::decay_t<T>>> as_opt() const {
         using Ty = std::decay_t<T>;
 
-        if constexpr (std::is_fundamental<Ty>::value) {
-            if (type_id() == typeid_bool)
-                return T(*(bool*)ptr());
-            else if (type_id() == typeid_int)
-                return T(*(int*)ptr());
-            else if (type_id() == typeid_char)
-                return T(*(char*)ptr());
-            else if (type_id() == typeid_float)
-                return T(*(float*)ptr());
-            else if (type_id() == typeid_double)
-                return T(*(double*)ptr());
-            else if (type_id() == typeid_size_t)
-                return T(*(size_t*)ptr());
-        }
-        if (type_id() != typeid(Ty).hash_code())
+        if (type_id() != type_id_of<Ty>())
             return std::nullopt;
 
         return *(Ty*)ptr();
     }
 
     Object& get_member(const std::string& name);
+    virtual Function* find_function(const std::string& name);
+
+    // members and methods are numbered per type, so that call sites can remember the index
+    // found for the type of the objects they see and skip the lookup by name, see InlineCache.
+    // the indices return -1 when there is no such member or method
+    virtual int member_index(const std::string&) const {
+        return -1;
+    }
+    virtual Object& member_at(int index);
+    virtual int method_index(const std::string&) const {
+        return -1;
+    }
+    // the method is not bound to this object, it runs on it through Function::run_method
+    virtual const Function& method_at(int index) const;
 
     std::string type_name() const {
         return get_type_name(type_id());
@@ -219,48 +302,93 @@ struct BaseObject {
         return type_id_;
     }
 
-    mutable std::map<std::string, Object> members;
+    // the methods of host objects in use, bound to the object
     mutable std::map<std::string, Function> functions;
 
     size_t type_id_ = -1;
 };
 
+// bool, char, int, int64_t, float and double are stored unboxed in "value" and tagged by "kind",
+// every other type lives in "base". an object holding neither is "void"
 struct Object {
-    static Object construct(const Object& type, const std::vector<Object>& args) {
-        LLC_CHECK(type.base != nullptr);
-        return type.base->construct(args);
+    enum class Kind : uint8_t { Boxed, Bool, Char, Int, Int64, Float, Double };
+
+    template <typename T>
+    static constexpr Kind kind_of() {
+        if constexpr (std::is_same_v<T, bool>)
+            return Kind::Bool;
+        else if constexpr (std::is_same_v<T, char>)
+            return Kind::Char;
+        else if constexpr (std::is_same_v<T, int>)
+            return Kind::Int;
+        else if constexpr (std::is_same_v<T, int64_t>)
+            return Kind::Int64;
+        else if constexpr (std::is_same_v<T, float>)
+            return Kind::Float;
+        else if constexpr (std::is_same_v<T, double>)
+            return Kind::Double;
+        else
+            return Kind::Boxed;
     }
 
-    Object() : base(nullptr){};
+    static Object construct(const Object& type, const std::vector<Object>& args);
+
+    Object() = default;
     explicit Object(std::unique_ptr<BaseObject> base) {
         LLC_CHECK(base != nullptr);
         this->base = std::move(base);
     }
     template <typename T, typename = typename std::enable_if<
                               !std::is_convertible<T, std::unique_ptr<BaseObject>>::value>::type>
-    explicit Object(T instance);
+    explicit Object(T instance) {
+        if constexpr (kind_of<T>() != Kind::Boxed) {
+            kind = kind_of<T>();
+            unboxed<T>() = instance;
+        } else {
+            box(instance);
+        }
+    }
 
-    Object(const Object& rhs) {
-        if (rhs.base != nullptr)
+    Object(const Object& rhs) : kind(rhs.kind), value(rhs.value) {
+        if (rhs.base != nullptr) {
             base.reset(rhs.base->clone());
+            CloneCounter::objects++;
+        }
+    }
+    Object(Object&& rhs) noexcept {
+        swap(rhs);
     }
     Object& operator=(Object rhs) {
-        std::swap(base, rhs.base);
+        swap(rhs);
         return *this;
     }
-
-    Object alloc() const {
-        return Object(std::unique_ptr<BaseObject>(base->alloc()));
+    void swap(Object& rhs) noexcept {
+        std::swap(kind, rhs.kind);
+        std::swap(value, rhs.value);
+        std::swap(base, rhs.base);
     }
 
-    void assign(const Object& rhs) {
-        LLC_CHECK(base != nullptr);
-        LLC_CHECK(rhs.base != nullptr);
-        base->assign(rhs.base.get());
+    bool is_void() const {
+        return kind == Kind::Boxed && base == nullptr;
     }
 
+    Object alloc() const;
+
+    void assign(const Object& rhs);
+
     template <typename T>
     T as() const {
+        using Ty = std::decay_t<T>;
+        if (kind != Kind::Boxed) {
+            if constexpr (std::is_reference_v<T> && kind_of<Ty>() != Kind::Boxed) {
+                if (kind == kind_of<Ty>())
+                    return const_cast<Object*>(this)->unboxed<Ty>();
+            } else if constexpr (std::is_fundamental_v<Ty>) {
+                return visit([](auto value) { return T(value); });
+            }
+            throw_exception("cannot convert type \"", type_name(), "\" to type \"",
+                            get_type_name<Ty>(), '"');
+        }
         if (base == nullptr)
             throw_exception("cannot cast \"void\" to type \"", get_type_name<T>(), '"');
         return base->as<T>();
@@ -268,110 +396,112 @@ struct Object {
 
     template <typename T>
     std::optional<T> as_opt() const {
+        if (kind != Kind::Boxed) {
+            if constexpr (std::is_fundamental_v<std::decay_t<T>>)
+                return visit([](auto value) { return std::optional<T>(T(value)); });
+            return std::nullopt;
+        }
         if (base == nullptr)
             throw_exception("cannot cast \"void\" to type \"", get_type_name<T>(), '"');
         return base->as_opt<T>();
     }
 
+    size_t type_id() const {
+        switch (kind) {
+        case Kind::Boxed: LLC_CHECK(base != nullptr); return base->type_id();
+        case Kind::Bool: return typeid_bool;
+        case Kind::Char: return typeid_char;
+        case Kind::Int: return typeid_int;
+        case Kind::Int64: return typeid_int64;
+        case Kind::Float: return typeid_float;
+        case Kind::Double: return typeid_double;
+        }
+        return -1;
+    }
     std::string type_name() const {
-        LLC_CHECK(base != nullptr);
-        return base->type_name();
+        return get_type_name(type_id());
     }
 
-    Object& operator+=(const Object& rhs) {
-        LLC_CHECK(rhs.base != nullptr);
-        base->add(rhs.base.get());
-        return *this;
-    }
-    Object& operator-=(const Object& rhs) {
-        LLC_CHECK(rhs.base != nullptr);
-        base->sub(rhs.base.get());
-        return *this;
-    }
-    Object& operator*=(const Object& rhs) {
-        LLC_CHECK(rhs.base != nullptr);
-        base->mul(rhs.base.get());
-        return *this;
-    }
-    Object& operator/=(const Object& rhs) {
-        LLC_CHECK(rhs.base != nullptr);
-        base->div(rhs.base.get());
-        return *this;
+    // calls "f" with a reference to the unboxed value, "kind" must not be Kind::Boxed
+    template <typename F>
+    decltype(auto) visit(F&& f) {
+        switch (kind) {
+        case Kind::Bool: return f(value.b);
+        case Kind::Char: return f(value.c);
+        case Kind::Int: return f(value.i);
+        case Kind::Int64: return f(value.l);
+        case Kind::Float: return f(value.f);
+        default: return f(value.d);
+        }
     }
-    Object operator-() {
-        return base->neg();
+    template <typename F>
+    decltype(auto) visit(F&& f) const {
+        return const_cast<Object*>(this)->visit(
+            [&f](auto& value) -> decltype(auto) { return f(std::as_const(value)); });
     }
-    Object& operator++() {
-        LLC_CHECK(base != nullptr);
-        base->increment();
-        return *this;
+
+    template <typename T>
+    T& unboxed() {
+        if constexpr (std::is_same_v<T, bool>)
+            return value.b;
+        else if constexpr (std::is_same_v<T, char>)
+            return value.c;
+        else if constexpr (std::is_same_v<T, int>)
+            return value.i;
+        else if constexpr (std::is_same_v<T, int64_t>)
+            return value.l;
+        else if constexpr (std::is_same_v<T, float>)
+            return value.f;
+        else
+            return value.d;
     }
+
+    Object& operator+=(const Object& rhs);
+    Object& operator-=(const Object& rhs);
+    Object& operator*=(const Object& rhs);
+    Object& operator/=(const Object& rhs);
+    Object operator-();
+    Object& operator++();
     Object operator++(int) {
-        LLC_CHECK(base != nullptr);
         Object temp = *this;
-        base->increment();
+        ++*this;
         return temp;
     }
-    Object& operator--() {
-        LLC_CHECK(base != nullptr);
-        base->decrement();
-        return *this;
-    }
+    Object& operator--();
     Object operator--(int) {
-        LLC_CHECK(base != nullptr);
         Object temp = *this;
-        base->decrement();
+        --*this;
         return temp;
     }
     friend Object operator+(Object lhs, const Object& rhs) {
-        return lhs += rhs;
+        lhs += rhs;
+        return lhs;
     }
     friend Object operator-(Object lhs, const Object& rhs) {
-        return lhs -= rhs;
+        lhs -= rhs;
+        return lhs;
     }
     friend Object operator*(Object lhs, const Object& rhs) {
-        return lhs *= rhs;
+        lhs *= rhs;
+        return lhs;
     }
     friend Object operator/(Object lhs, const Object& rhs) {
-        return lhs /= rhs;
-    }
-    friend bool operator<(const Object& lhs, const Object& rhs) {
-        LLC_CHECK(lhs.base != nullptr);
-        LLC_CHECK(rhs.base != nullptr);
-        return lhs.base->less_than(rhs.base.get());
-    }
-    friend bool operator<=(const Object& lhs, const Object& rhs) {
-        LLC_CHECK(lhs.base != nullptr);
-        LLC_CHECK(rhs.base != nullptr);
-        return lhs.base->less_equal(rhs.base.get());
-    }
-    friend bool operator>(const Object& lhs, const Object& rhs) {
-        LLC_CHECK(lhs.base != nullptr);
-        LLC_CHECK(rhs.base != nullptr);
-        return lhs.base->greater_than(rhs.base.get());
-    }
-    friend bool operator>=(const Object& lhs, const Object& rhs) {
-        LLC_CHECK(lhs.base != nullptr);
-        LLC_CHECK(rhs.base != nullptr);
-        return lhs.base->greater_equal(rhs.base.get());
-    }
-    friend bool operator==(const Object& lhs, const Object& rhs) {
-        LLC_CHECK(lhs.base != nullptr);
-        LLC_CHECK(rhs.base != nullptr);
-        return lhs.base->equal(rhs.base.get());
-    }
-    friend bool operator!=(const Object& lhs, const Object& rhs) {
-        LLC_CHECK(lhs.base != nullptr);
-        LLC_CHECK(rhs.base != nullptr);
-        return lhs.base->not_equal(rhs.base.get());
+        lhs /= rhs;
+        return lhs;
     }
+    friend bool operator<(const Object& lhs, const Object& rhs);
+    friend bool operator<=(const Object& lhs, const Object& rhs);
+    friend bool operator>(const Object& lhs, const Object& rhs);
+    friend bool operator>=(const Object& lhs, const Object& rhs);
+    friend bool operator==(const Object& lhs, const Object& rhs);
+    friend bool operator!=(const Object& lhs, const Object& rhs);
 
     Object& operator[](std::string name) & {
-        LLC_CHECK(base != nullptr);
+        if (base == nullptr)
+            throw_exception("cannot find member \"", name, '"');
         return base->get_member(name);
     }
     Object& operator[](std::string) && {
-        LLC_CHECK(base != nullptr);
         throw_exception("cannot get member(which store a reference to part of that temporary "
                         "object) of temporary object");
         static Object null_object;
@@ -394,159 +524,232 @@ struct Object {
         size_t index;
     };
     ArrayElementProxy operator[](size_t index) {
-        LLC_CHECK(base != nullptr);
+        if (base == nullptr)
+            throw_exception("type \"", type_name(), "\" does not have operator \"[]\"");
         return ArrayElementProxy(base.get(), index);
     }
 
+    Kind kind = Kind::Boxed;
+    union Value {
+        bool b;
+        char c;
+        int i;
+        int64_t l;
+        float f;
+        double d;
+    } value = {};
     std::unique_ptr<BaseObject> base;
+
+  private:
+    template <typename T>
+    void box(T instance);
 };
 
+// the operators of a script value of type T, shared by unboxed values and ConcreteObject
 template <typename T>
-struct ConcreteObject : BaseObject {
-    ConcreteObject() = default;
-    ConcreteObject(T value) : BaseObject(typeid(T).hash_code()), value(value){};
-
-    BaseObject* clone() const override;
-    BaseObject* alloc() const override {
-        using Ty = std::decay_t<T>;
-        if constexpr (!std::is_pointer<T>::value) {
-            type_id_to_name[typeid(Ty*).hash_code()] = get_type_name<Ty>() + "*";
-            return new ConcreteObject<Ty*>(new Ty(value));
-        } else {
-            throw_exception("only one level of indirection is supported");
-            return nullptr;
-        }
-    }
-
-    Object construct(const std::vector<Object>& objects) const override {
-        if constexpr (std::is_fundamental_v<T>) {
-            if (objects.size() > 1)
-                throw_exception("more than one arguments passed to the constructor of type \"",
-                                type_name(), '"');
-            return objects.size() ? Object(objects[0].as<T>()) : Object(T());
-        } else {
-            if (constructors.size() == 0)
-                throw_exception("no constructor was binded for type \"", type_name(), '"');
-            for (const auto& ctor : constructors)
-                if (ctor->is_viable(objects))
-                    return ctor->construct(objects);
-            throw_exception("no viable constructor found for type \"", type_name(), '"');
-            return {};
-        }
-    }
-
-    void* ptr() const override {
-        return (void*)&value;
-    }
-    void assign(const BaseObject* rhs) override {
-        value = rhs->as<typename std::decay_t<T>>();
-    }
-
-    void bind_members() {
-        for (const auto& accessor : accessors)
-            members[accessor.first] = accessor.second->access(value);
-    }
+struct Operators {
+    using Ty = std::decay_t<T>;
 
-    void add(BaseObject* rhs) override {
+    static void add(Ty& value, const Object& rhs) {
         if constexpr (HasOperatorAdd<T>::value)
-            value += rhs->as<T>();
+            value += rhs.as<Ty>();
         else
-            throw_exception("type \"", type_name(), "\" does not have operator \"+\"");
+            throw_exception("type \"", get_type_name<Ty>(), "\" does not have operator \"+\"");
     }
-    void sub(BaseObject* rhs) override {
+    static void sub(Ty& value, const Object& rhs) {
         if constexpr (HasOperatorSub<T>::value && !std::is_pointer<T>::value)
-            value -= rhs->as<T>();
+            value -= rhs.as<Ty>();
         else
-            throw_exception("type \"", type_name(), "\" does not have operator \"-\"");
+            throw_exception("type \"", get_type_name<Ty>(), "\" does not have operator \"-\"");
     }
-    void mul(BaseObject* rhs) override {
-        if constexpr (HasOperatorMul<T>::value)
-            value *= rhs->as<T>();
+    static void mul(Ty& value, const Object& rhs) {
+        if constexpr (std::is_same_v<Ty, bool>)
+            value = value && rhs.as<bool>();
+        else if constexpr (HasOperatorMul<T>::value)
+            value *= rhs.as<Ty>();
         else
-            throw_exception("type \"", type_name(), "\" does not have operator \"*\"");
+            throw_exception("type \"", get_type_name<Ty>(), "\" does not have operator \"*\"");
     }
-    void div(BaseObject* rhs) override {
+    static void div(Ty& value, const Object& rhs) {
         if constexpr (HasOperatorDiv<T>::value)
-            value /= rhs->as<T>();
+            value /= rhs.as<Ty>();
         else
-            throw_exception("type \"", type_name(), "\" does not have operator \"/\"");
+            throw_exception("type \"", get_type_name<Ty>(), "\" does not have operator \"/\"");
     }
-    Object neg() const override {
+    static Object neg(const Ty& value) {
         if constexpr (HasOperatorNegation<T>::value)
             return Object(-value);
         else
-            throw_exception("type \"", type_name(), "\" does not have operator \"/\"");
+            throw_exception("type \"", get_type_name<Ty>(), "\" does not have operator \"-\"");
         return {};
     }
-    void increment() override {
+    static void increment(Ty& value) {
         if constexpr (HasOperatorPreIncrement<T>::value)
             ++value;
         else
-            throw_exception("type \"", type_name(), "\" does not have operator \"++\"");
+            throw_exception("type \"", get_type_name<Ty>(), "\" does not have operator \"++\"");
     }
-    void decrement() override {
+    static void decrement(Ty& value) {
         if constexpr (HasOperatorPreIncrement<T>::value)
             --value;
         else
-            throw_exception("type \"", type_name(), "\" does not have operator \"--\"");
+            throw_exception("type \"", get_type_name<Ty>(), "\" does not have operator \"--\"");
     }
-    bool less_than(BaseObject* rhs) const override {
+    static bool less_than(const Ty& value, const Object& rhs) {
         if constexpr (HasOperatorLT<T>::value)
-            return value < rhs->as<T>();
+            return value < rhs.as<Ty>();
         else
-            throw_exception("type \"", type_name(), "\" does not have operator \"<\"");
+            throw_exception("type \"", get_type_name<Ty>(), "\" does not have operator \"<\"");
         return {};
     }
-    bool less_equal(BaseObject* rhs) const override {
+    static bool less_equal(const Ty& value, const Object& rhs) {
         if constexpr (HasOperatorLE<T>::value)
-            return value <= rhs->as<T>();
+            return value <= rhs.as<Ty>();
         else
-            throw_exception("type \"", type_name(), "\" does not have operator \"<=\"");
+            throw_exception("type \"", get_type_name<Ty>(), "\" does not have operator \"<=\"");
         return {};
     }
-    bool greater_than(BaseObject* rhs) const override {
+    static bool greater_than(const Ty& value, const Object& rhs) {
         if constexpr (HasOperatorGT<T>::value)
-            return value > rhs->as<T>();
+            return value > rhs.as<Ty>();
         else
-            throw_exception("type \"", type_name(), "\" does not have operator \">\"");
+            throw_exception("type \"", get_type_name<Ty>(), "\" does not have operator \">\"");
         return {};
     }
-    bool greater_equal(BaseObject* rhs) const override {
+    static bool greater_equal(const Ty& value, const Object& rhs) {
         if constexpr (HasOperatorGE<T>::value)
-            return value >= rhs->as<T>();
+            return value >= rhs.as<Ty>();
         else
-            throw_exception("type \"", type_name(), "\" does not have operator \">=\"");
+            throw_exception("type \"", get_type_name<Ty>(), "\" does not have operator \">=\"");
         return {};
     }
-    bool equal(BaseObject* rhs) const override {
+    static bool equal(const Ty& value, const Object& rhs) {
         if constexpr (HasOperatorEQ<T>::value)
-            return value == rhs->as<T>();
+            return value == rhs.as<Ty>();
         else
-            throw_exception("type \"", type_name(), "\" does not have operator \"==\"");
+            throw_exception("type \"", get_type_name<Ty>(), "\" does not have operator \"==\"");
         return {};
     }
-    bool not_equal(BaseObject* rhs) const override {
+    static bool not_equal(const Ty& value, const Object& rhs) {
         if constexpr (HasOperatorNE<T>::value)
-            return value != rhs->as<T>();
+            return value != rhs.as<Ty>();
         else
-            throw_exception("type \"", type_name(), "\" does not have operator \"!=\"");
+            throw_exception("type \"", get_type_name<Ty>(), "\" does not have operator \"!=\"");
         return {};
     }
-    Object get_element(size_t index) const override {
-        if constexpr (HasOperatorArrayAccess<const T>::value)
-            return (Object)std::make_unique<ConcreteObject<std::decay_t<decltype(value[index])>>>(
-                value[index]);
-        else
-            throw_exception("type \"", type_name(), "\" does not have operator \"[]\" const");
-        return {};
+};
+
+#define LLC_UNBOXED_OPERATOR(name)                                                                 \
+    [&](auto& value) { return Operators<std::decay_t<decltype(value)>>::name(value, rhs); }
+
+inline void Object::assign(const Object& rhs) {
+    // variables of no declared type, such as the temporaries of the optimizer, take any value
+    if (is_void()) {
+        *this = rhs;
+        return;
     }
-    void set_element(size_t index, Object object) override {
-        if constexpr (HasOperatorArrayAccess<T>::value)
-            value[index] = object.as<std::decay_t<decltype(value[index])>>();
-        else
-            throw_exception("type \"", type_name(), "\" does not have operator \"[]\"");
+    if (kind != Kind::Boxed)
+        return visit([&](auto& value) { value = rhs.as<std::decay_t<decltype(value)>>(); });
+    LLC_CHECK(base != nullptr);
+    LLC_CHECK(!rhs.is_void());
+    base->assign(rhs);
+}
+inline Object& Object::operator+=(const Object& rhs) {
+    LLC_CHECK(!rhs.is_void());
+    if (kind != Kind::Boxed)
+        visit(LLC_UNBOXED_OPERATOR(add));
+    else
+        base->add(rhs);
+    return *this;
+}
+inline Object& Object::operator-=(const Object& rhs) {
+    LLC_CHECK(!rhs.is_void());
+    if (kind != Kind::Boxed)
+        visit(LLC_UNBOXED_OPERATOR(sub));
+    else
+        base->sub(rhs);
+    return *this;
+}
+inline Object& Object::operator*=(const Object& rhs) {
+    LLC_CHECK(!rhs.is_void());
+    if (kind != Kind::Boxed)
+        visit(LLC_UNBOXED_OPERATOR(mul));
+    else
+        base->mul(rhs);
+    return *this;
+}
+inline Object& Object::operator/=(const Object& rhs) {
+    LLC_CHECK(!rhs.is_void());
+    if (kind != Kind::Boxed)
+        visit(LLC_UNBOXED_OPERATOR(div));
+    else
+        base->div(rhs);
+    return *this;
+}
+inline Object Object::operator-() {
+    if (kind != Kind::Boxed)
+        return visit(
+            [](auto& value) { return Operators<std::decay_t<decltype(value)>>::neg(value); });
+    return base->neg();
+}
+inline Object& Object::operator++() {
+    if (kind != Kind::Boxed)
+        visit([](auto& value) { Operators<std::decay_t<decltype(value)>>::increment(value); });
+    else {
+        LLC_CHECK(base != nullptr);
+        base->increment();
     }
+    return *this;
+}
+inline Object& Object::operator--() {
+    if (kind != Kind::Boxed)
+        visit([](auto& value) { Operators<std::decay_t<decltype(value)>>::decrement(value); });
+    else {
+        LLC_CHECK(base != nullptr);
+        base->decrement();
+    }
+    return *this;
+}
+
+#define LLC_OBJECT_COMPARISON(op, name)                                                            \
+    inline bool operator op(const Object& lhs, const Object& rhs) {                               \
+        LLC_CHECK(!lhs.is_void());                                                                 \
+        LLC_CHECK(!rhs.is_void());                                                                 \
+        if (lhs.kind != Object::Kind::Boxed)                                                       \
+            return lhs.visit(LLC_UNBOXED_OPERATOR(name));                                          \
+        return lhs.base->name(rhs);                                                                \
+    }
+
+LLC_OBJECT_COMPARISON(<, less_than)
+LLC_OBJECT_COMPARISON(<=, less_equal)
+LLC_OBJECT_COMPARISON(>, greater_than)
+LLC_OBJECT_COMPARISON(>=, greater_equal)
+LLC_OBJECT_COMPARISON(==, equal)
+LLC_OBJECT_COMPARISON(!=, not_equal)
+
+#undef LLC_OBJECT_COMPARISON
+#undef LLC_UNBOXED_OPERATOR
+
+struct Token {
+    TokenType type = TokenType::Invalid;
+    Location location;
+
+    // numbers are typed like C literals: integers are int, or int64_t when they do not fit in an
+    // int or end with "l", reals are double, or float when they end with "f". true and false are
+    // bool
+    Object value;
+    char value_c;
+    std::string value_s;
+    std::string id;
+};
 
+template <typename T>
+struct ConcreteObject;
+
+// what is shared by every object of a host type T: its name, and the members, constructors and
+// methods bound through Program::bind. objects of the type only point to it
+template <typename T>
+struct TypeInfo {
     struct Accessor {
         virtual ~Accessor() = default;
         virtual Object access(T& object) const = 0;
@@ -599,113 +802,288 @@ struct ConcreteObject : BaseObject {
         }
     };
 
-    T value;
-    std::map<std::string, std::shared_ptr<Accessor>> accessors;
+    // members and methods are numbered in the order they are bound, see BaseObject::member_index
+    template <typename U>
+    static void add(std::vector<U>& items, std::unordered_map<std::string, int>& indices,
+                    const std::string& name, U item) {
+        auto it = indices.find(name);
+        if (it != indices.end()) {
+            items[it->second] = std::move(item);
+        } else {
+            indices[name] = (int)items.size();
+            items.push_back(std::move(item));
+        }
+    }
+
+    std::string name;
+    std::vector<std::shared_ptr<Accessor>> accessors;
+    std::unordered_map<std::string, int> accessor_indices;
     std::vector<std::shared_ptr<Constructor>> constructors;
+    std::vector<Function> methods;
+    std::unordered_map<std::string, int> method_indices;
+};
+
+template <typename T>
+struct ConcreteObject : BaseObject {
+    ConcreteObject() = default;
+    ConcreteObject(T value, std::shared_ptr<const TypeInfo<T>> info = nullptr)
+        : BaseObject(type_id_of<T>()), value(value), info(info){};
+
+    BaseObject* clone() const override {
+        return new ConcreteObject<T>(value, info);
+    }
+    BaseObject* alloc() const override {
+        using Ty = std::decay_t<T>;
+        if constexpr (!std::is_pointer<T>::value) {
+            set_type_name<Ty*>(get_type_name<Ty>() + "*");
+            return new ConcreteObject<Ty*>(Heap::current().make<Ty>(value));
+        } else {
+            throw_exception("only one level of indirection is supported");
+            return nullptr;
+        }
+    }
+
+    Object construct(const std::vector<Object>& objects) const override {
+        if constexpr (std::is_fundamental_v<T>) {
+            if (objects.size() > 1)
+                throw_exception("more than one arguments passed to the constructor of type \"",
+                                type_name(), '"');
+            return objects.size() ? Object(objects[0].as<T>()) : Object(T());
+        } else {
+            if (info == nullptr || info->constructors.size() == 0)
+                throw_exception("no constructor was binded for type \"", type_name(), '"');
+            for (const auto& ctor : info->constructors)
+                if (ctor->is_viable(objects)) {
+                    Object object = ctor->construct(objects);
+                    static_cast<ConcreteObject<T>*>(object.base.get())->info = info;
+                    return object;
+                }
+            throw_exception("no viable constructor found for type \"", type_name(), '"');
+            return {};
+        }
+    }
+
+    void* ptr() const override {
+        return (void*)&value;
+    }
+    void assign(const Object& rhs) override {
+        value = rhs.as<typename std::decay_t<T>>();
+    }
+
+    int member_index(const std::string& name) const override {
+        if (info == nullptr)
+            return -1;
+        auto it = info->accessor_indices.find(name);
+        return it == info->accessor_indices.end() ? -1 : it->second;
+    }
+    // a member is an object referring to the field of "value", made the first time it is used
+    Object& member_at(int index) override {
+        if (info == nullptr || index >= (int)info->accessors.size())
+            return BaseObject::member_at(index);
+        if (index >= (int)members.size())
+            members.resize(info->accessors.size());
+        if (members[index].is_void())
+            members[index] = info->accessors[index]->access(value);
+        return members[index];
+    }
+    int method_index(const std::string& name) const override {
+        if (info == nullptr)
+            return -1;
+        auto it = info->method_indices.find(name);
+        return it == info->method_indices.end() ? -1 : it->second;
+    }
+    const Function& method_at(int index) const override {
+        if (info == nullptr || index >= (int)info->methods.size())
+            return BaseObject::method_at(index);
+        return info->methods[index];
+    }
+    Function* find_function(const std::string& name) override;
+
+    void add(const Object& rhs) override {
+        Operators<T>::add(value, rhs);
+    }
+    void sub(const Object& rhs) override {
+        Operators<T>::sub(value, rhs);
+    }
+    void mul(const Object& rhs) override {
+        Operators<T>::mul(value, rhs);
+    }
+    void div(const Object& rhs) override {
+        Operators<T>::div(value, rhs);
+    }
+    Object neg() const override {
+        return Operators<T>::neg(value);
+    }
+    void increment() override {
+        Operators<T>::increment(value);
+    }
+    void decrement() override {
+        Operators<T>::decrement(value);
+    }
+    bool less_than(const Object& rhs) const override {
+        return Operators<T>::less_than(value, rhs);
+    }
+    bool less_equal(const Object& rhs) const override {
+        return Operators<T>::less_equal(value, rhs);
+    }
+    bool greater_than(const Object& rhs) const override {
+        return Operators<T>::greater_than(value, rhs);
+    }
+    bool greater_equal(const Object& rhs) const override {
+        return Operators<T>::greater_equal(value, rhs);
+    }
+    bool equal(const Object& rhs) const override {
+        return Operators<T>::equal(value, rhs);
+    }
+    bool not_equal(const Object& rhs) const override {
+        return Operators<T>::not_equal(value, rhs);
+    }
+    Object get_element(size_t index) const override {
+        if constexpr (HasOperatorArrayAccess<const T>::value)
+            return Object(std::decay_t<decltype(value[index])>(value[index]));
+        else
+            throw_exception("type \"", type_name(), "\" does not have operator \"[]\" const");
+        return {};
+    }
+    void set_element(size_t index, Object object) override {
+        if constexpr (HasOperatorArrayAccess<T>::value)
+            value[index] = object.as<std::decay_t<decltype(value[index])>>();
+        else
+            throw_exception("type \"", type_name(), "\" does not have operator \"[]\"");
+    }
+
+    T value;
+    std::shared_ptr<const TypeInfo<T>> info;
+    std::vector<Object> members;
+};
+
+// what is shared by every object of a struct declared by a program: the names of its fields in the
+// order of their offsets, and its methods
+struct StructInfo {
+    std::vector<std::string> fields;
+    std::unordered_map<std::string, int> offsets;
+    std::vector<Function> methods;
+    std::unordered_map<std::string, int> method_indices;
 };
 
+// the fields of a struct are laid out in "fields" at the offsets of StructInfo, so copying an
+// object copies its fields and nothing else
 struct InternalObject : BaseObject {
-    using BaseObject::BaseObject;
+    InternalObject(size_t type_id, std::shared_ptr<StructInfo> info, std::vector<Object> fields)
+        : BaseObject(type_id), fields(std::move(fields)), info(std::move(info)){};
 
-    BaseObject* clone() const override;
+    BaseObject* clone() const override {
+        return new InternalObject(type_id(), info, fields);
+    }
     BaseObject* alloc() const override {
         throw_exception("internal object does not support \"new\"");
         return nullptr;
     }
 
     Object construct(const std::vector<Object>& objects) const override {
-        LLC_CHECK(objects.size() == members.size());
+        LLC_CHECK(objects.size() == fields.size());
         throw_exception("internal object does not support constructor yet");
         return {};
     }
 
+    int member_index(const std::string& name) const override {
+        auto it = info->offsets.find(name);
+        return it == info->offsets.end() ? -1 : it->second;
+    }
+    Object& member_at(int index) override {
+        return fields[index];
+    }
+    int method_index(const std::string& name) const override {
+        auto it = info->method_indices.find(name);
+        return it == info->method_indices.end() ? -1 : it->second;
+    }
+    const Function& method_at(int index) const override {
+        return info->methods[index];
+    }
+    Function* find_function(const std::string& name) override;
+
     void* ptr() const override {
         throw_exception("cannot get pointer to internal type");
         return nullptr;
     };
-    void assign(const BaseObject* rhs) override {
-        auto ptr = dynamic_cast<const InternalObject*>(rhs);
-        if (ptr == nullptr)
-            throw_exception("assign external type to internal type is not allowed");
-        for (auto& member : ptr->members)
-            members[member.first] = member.second;
-    }
-    void add(BaseObject* rhs) override {
-        auto ptr = dynamic_cast<const InternalObject*>(rhs);
-        if (ptr == nullptr)
-            throw_exception("add external type to internal type is not allowed");
-        for (auto& member : ptr->members)
-            members[member.first] += member.second;
-    }
-    void sub(BaseObject* rhs) override {
-        auto ptr = dynamic_cast<const InternalObject*>(rhs);
-        if (ptr == nullptr)
-            throw_exception("subtract internal type by external type is not allowed");
-        for (auto& member : ptr->members)
-            members[member.first] -= member.second;
-    }
-    void mul(BaseObject* rhs) override {
-        auto ptr = dynamic_cast<const InternalObject*>(rhs);
-        if (ptr == nullptr)
-            throw_exception("multiply internal type by external type is not allowed");
-        for (auto& member : ptr->members)
-            members[member.first] *= member.second;
-    }
-    void div(BaseObject* rhs) override {
-        auto ptr = dynamic_cast<const InternalObject*>(rhs);
-        if (ptr == nullptr)
-            throw_exception("divide internal type by external type is not allowed");
-        for (auto& member : ptr->members)
-            members[member.first] /= member.second;
+    void assign(const Object& rhs) override {
+        const auto& rhs_fields = fields_of(rhs, "assign");
+        for (size_t i = 0; i < fields.size(); i++)
+            fields[i] = rhs_fields[i];
+    }
+    void add(const Object& rhs) override {
+        const auto& rhs_fields = fields_of(rhs, "add");
+        for (size_t i = 0; i < fields.size(); i++)
+            fields[i] += rhs_fields[i];
+    }
+    void sub(const Object& rhs) override {
+        const auto& rhs_fields = fields_of(rhs, "subtract");
+        for (size_t i = 0; i < fields.size(); i++)
+            fields[i] -= rhs_fields[i];
+    }
+    void mul(const Object& rhs) override {
+        const auto& rhs_fields = fields_of(rhs, "multiply");
+        for (size_t i = 0; i < fields.size(); i++)
+            fields[i] *= rhs_fields[i];
+    }
+    void div(const Object& rhs) override {
+        const auto& rhs_fields = fields_of(rhs, "divide");
+        for (size_t i = 0; i < fields.size(); i++)
+            fields[i] /= rhs_fields[i];
     }
     Object neg() const override {
-        std::unique_ptr<BaseObject> copy(clone());
-        InternalObject* ptr = dynamic_cast<InternalObject*>(copy.get());
-        for (auto& member : ptr->members)
-            ptr->members[member.first] = -member.second;
-        return Object(std::move(copy));
+        std::vector<Object> negated = fields;
+        for (auto& field : negated)
+            field = -field;
+        return Object(std::make_unique<InternalObject>(type_id(), info, std::move(negated)));
     }
     void increment() override {
-        for (auto& member : members)
-            ++member.second;
+        for (auto& field : fields)
+            ++field;
     }
     void decrement() override {
-        for (auto& member : members)
-            --member.second;
+        for (auto& field : fields)
+            --field;
     }
-    bool less_than(BaseObject* rhs) const override {
-        for (const auto& it : rhs->members)
-            if (members[it.first] >= it.second)
+    bool less_than(const Object& rhs) const override {
+        const auto& rhs_fields = fields_of(rhs, "compare");
+        for (size_t i = 0; i < fields.size(); i++)
+            if (fields[i] >= rhs_fields[i])
                 return false;
         return true;
     }
-    bool less_equal(BaseObject* rhs) const override {
-        for (const auto& it : rhs->members)
-            if (members[it.first] > it.second)
+    bool less_equal(const Object& rhs) const override {
+        const auto& rhs_fields = fields_of(rhs, "compare");
+        for (size_t i = 0; i < fields.size(); i++)
+            if (fields[i] > rhs_fields[i])
                 return false;
         return true;
     }
-    bool greater_than(BaseObject* rhs) const override {
-        for (const auto& it : rhs->members)
-            if (members[it.first] <= it.second)
+    bool greater_than(const Object& rhs) const override {
+        const auto& rhs_fields = fields_of(rhs, "compare");
+        for (size_t i = 0; i < fields.size(); i++)
+            if (fields[i] <= rhs_fields[i])
                 return false;
         return true;
     }
-    bool greater_equal(BaseObject* rhs) const override {
-        for (const auto& it : rhs->members)
-            if (members[it.first] < it.second)
+    bool greater_equal(const Object& rhs) const override {
+        const auto& rhs_fields = fields_of(rhs, "compare");
+        for (size_t i = 0; i < fields.size(); i++)
+            if (fields[i] < rhs_fields[i])
                 return false;
         return true;
     }
-    bool equal(BaseObject* rhs) const override {
-        for (const auto& it : rhs->members)
-            if (members[it.first] != it.second)
+    bool equal(const Object& rhs) const override {
+        const auto& rhs_fields = fields_of(rhs, "compare");
+        for (size_t i = 0; i < fields.size(); i++)
+            if (fields[i] != rhs_fields[i])
                 return false;
         return true;
     }
-    bool not_equal(BaseObject* rhs) const override {
-        for (const auto& it : rhs->members)
-            if (members[it.first] != it.second)
+    bool not_equal(const Object& rhs) const override {
+        const auto& rhs_fields = fields_of(rhs, "compare");
+        for (size_t i = 0; i < fields.size(); i++)
+            if (fields[i] != rhs_fields[i])
                 return true;
         return false;
     }
@@ -716,10 +1094,49 @@ struct InternalObject : BaseObject {
     void set_element(size_t, Object) override {
         throw_exception("internal type does not support operator []");
     }
+
+    std::vector<Object> fields;
+    std::shared_ptr<StructInfo> info;
+
+  private:
+    const std::vector<Object>& fields_of(const Object& rhs, const char* operation) const {
+        auto ptr = dynamic_cast<const InternalObject*>(rhs.base.get());
+        if (ptr == nullptr || ptr->info != info)
+            throw_exception("cannot ", operation, " \"", type_name(), "\" and \"",
+                            rhs.type_name(), '"');
+        return ptr->fields;
+    }
 };
 
-template <typename T, typename>
-Object::Object(T instance) : base(std::make_unique<ConcreteObject<T>>(instance)) {
+template <typename T>
+void Object::box(T instance) {
+    base = std::make_unique<ConcreteObject<T>>(instance);
+}
+
+inline Object Object::construct(const Object& type, const std::vector<Object>& args) {
+    if (type.kind == Kind::Boxed) {
+        LLC_CHECK(type.base != nullptr);
+        return type.base->construct(args);
+    }
+    if (args.size() > 1)
+        throw_exception("more than one arguments passed to the constructor of type \"",
+                        type.type_name(), '"');
+    Object object = type;
+    object.visit([&](auto& value) {
+        using Ty = std::decay_t<decltype(value)>;
+        value = args.size() ? args[0].as<Ty>() : Ty();
+    });
+    return object;
+}
+
+inline Object Object::alloc() const {
+    if (kind != Kind::Boxed)
+        return visit([](auto value) {
+            ConcreteObject<decltype(value)> boxed(value);
+            return Object(std::unique_ptr<BaseObject>(boxed.alloc()));
+        });
+    LLC_CHECK(base != nullptr);
+    return Object(std::unique_ptr<BaseObject>(base->alloc()));
 }
 
 struct InternalFunction : BaseFunction {
@@ -728,21 +1145,38 @@ struct InternalFunction : BaseFunction {
     }
     std::optional<Object> run(const Scope& scope,
                               const std::vector<Expression>& exprs) const override;
+    std::optional<Object> run_method(const Scope& scope, const std::vector<Expression>& exprs,
+                                     BaseObject* self) const override;
+    std::optional<Object> call(const Scope& scope, const std::vector<Object>& args) const override {
+        return call(scope, args, nullptr);
+    }
+    std::optional<Object> call(const Scope& scope, const std::vector<Object>& args,
+                               InternalObject* self) const;
+    void enter(Frame& frame, const std::vector<Object>& args, const Frame* caller,
+               InternalObject* self = nullptr) const;
+    size_t return_type_id() const override {
+        return return_type.is_void() ? typeid_unknown : return_type.type_id();
+    }
 
     Object return_type;
     std::shared_ptr<Scope> definition;
-    std::map<std::string, Object*> this_scope;
     std::vector<std::string> parameters;
+    std::shared_ptr<NativeFunction> native;
 };
 
 struct ExternalFunction : BaseFunction {
     std::optional<Object> run(const Scope& scope,
                               const std::vector<Expression>& exprs) const override;
+    std::optional<Object> call(const Scope&, const std::vector<Object>& args) const override {
+        return invoke(args);
+    }
     virtual void bind_object(BaseObject*) {
     }
 
   protected:
     virtual Object invoke(const std::vector<Object>& args) const = 0;
+    static void arguments(std::vector<Object>& arguments, const Scope& scope,
+                          const std::vector<Expression>& exprs);
 };
 
 template <typename Return, typename... Args>
@@ -750,6 +1184,13 @@ struct ConcreteFunction : ExternalFunction {
     using F = Return (*)(Args...);
     ConcreteFunction(F f) : f(f){};
 
+    size_t return_type_id() const override {
+        if constexpr (std::is_void_v<Return>)
+            return typeid_unknown;
+        else
+            return type_id_of<Return>();
+    }
+
     BaseFunction* clone() const override {
         return new ConcreteFunction<Return, Args...>(*this);
     }
@@ -810,51 +1251,51 @@ struct ConcreteFunction : ExternalFunction {
 
         } else {
             if constexpr (sizeof...(Args) == 0)
-                return f();
+                return Object(f());
             else if constexpr (sizeof...(Args) == 1)
-                return f(args[0].as<decltype(types.template at<0>())>());
+                return Object(f(args[0].as<decltype(types.template at<0>())>()));
             else if constexpr (sizeof...(Args) == 2)
-                return f(args[0].as<decltype(types.template at<0>())>(),
-                         args[1].as<decltype(types.template at<1>())>());
+                return Object(f(args[0].as<decltype(types.template at<0>())>(),
+                         args[1].as<decltype(types.template at<1>())>()));
             else if constexpr (sizeof...(Args) == 3)
-                return f(args[0].as<decltype(types.template at<0>())>(),
+                return Object(f(args[0].as<decltype(types.template at<0>())>(),
                          args[1].as<decltype(types.template at<1>())>(),
-                         args[2].as<decltype(types.template at<2>())>());
+                         args[2].as<decltype(types.template at<2>())>()));
             else if constexpr (sizeof...(Args) == 4)
-                return f(args[0].as<decltype(types.template at<0>())>(),
+                return Object(f(args[0].as<decltype(types.template at<0>())>(),
                          args[1].as<decltype(types.template at<1>())>(),
                          args[2].as<decltype(types.template at<2>())>(),
-                         args[3].as<decltype(types.template at<3>())>());
+                         args[3].as<decltype(types.template at<3>())>()));
             else if constexpr (sizeof...(Args) == 5)
-                return f(args[0].as<decltype(types.template at<0>())>(),
+                return Object(f(args[0].as<decltype(types.template at<0>())>(),
                          args[1].as<decltype(types.template at<1>())>(),
                          args[2].as<decltype(types.template at<2>())>(),
                          args[3].as<decltype(types.template at<3>())>(),
-                         args[4].as<decltype(types.template at<4>())>());
+                         args[4].as<decltype(types.template at<4>())>()));
             else if constexpr (sizeof...(Args) == 6)
-                return f(args[0].as<decltype(types.template at<0>())>(),
+                return Object(f(args[0].as<decltype(types.template at<0>())>(),
                          args[1].as<decltype(types.template at<1>())>(),
                          args[2].as<decltype(types.template at<2>())>(),
                          args[3].as<decltype(types.template at<3>())>(),
                          args[4].as<decltype(types.template at<4>())>(),
-                         args[5].as<decltype(types.template at<5>())>());
+                         args[5].as<decltype(types.template at<5>())>()));
             else if constexpr (sizeof...(Args) == 7)
-                return f(args[0].as<decltype(types.template at<0>())>(),
+                return Object(f(args[0].as<decltype(types.template at<0>())>(),
                          args[1].as<decltype(types.template at<1>())>(),
                          args[2].as<decltype(types.template at<2>())>(),
                          args[3].as<decltype(types.template at<3>())>(),
                          args[4].as<decltype(types.template at<4>())>(),
                          args[5].as<decltype(types.template at<5>())>(),
-                         args[6].as<decltype(types.template at<6>())>());
+                         args[6].as<decltype(types.template at<6>())>()));
             else if constexpr (sizeof...(Args) == 8)
-                return f(args[0].as<decltype(types.template at<0>())>(),
+                return Object(f(args[0].as<decltype(types.template at<0>())>(),
                          args[1].as<decltype(types.template at<1>())>(),
                          args[2].as<decltype(types.template at<2>())>(),
                          args[3].as<decltype(types.template at<3>())>(),
                          args[4].as<decltype(types.template at<4>())>(),
                          args[5].as<decltype(types.template at<5>())>(),
                          args[6].as<decltype(types.template at<6>())>(),
-                         args[7].as<decltype(types.template at<7>())>());
+                         args[7].as<decltype(types.template at<7>())>()));
             else
                 throw_exception("too many arguments, only support <= 8");
         }
@@ -873,34 +1314,51 @@ struct ConcreteMemberFunction : ExternalFunction {
     BaseFunction* clone() const override {
         return new ConcreteMemberFunction<T, R, Args...>(*this);
     }
+    size_t return_type_id() const override {
+        if constexpr (std::is_void_v<R>)
+            return typeid_unknown;
+        else
+            return type_id_of<std::decay_t<R>>();
+    }
     void bind_object(BaseObject* ptr) override {
         object = dynamic_cast<ConcreteObject<T>*>(ptr);
         LLC_CHECK(object != nullptr);
     }
+    // methods found through BaseObject::method_at are not bound and run on "self"
+    std::optional<Object> run_method(const Scope& scope, const std::vector<Expression>& exprs,
+                                     BaseObject* self) const override {
+        auto target = self ? dynamic_cast<ConcreteObject<T>*>(self) : object;
+        ScratchVector<Object> args;
+        arguments(args.values, scope, exprs);
+        return invoke_on(target, args.values);
+    }
     Object invoke(const std::vector<Object>& args) const override {
+        return invoke_on(object, args);
+    }
+    Object invoke_on(ConcreteObject<T>* target, const std::vector<Object>& args) const {
         LLC_CHECK(args.size() == sizeof...(Args));
         TypePack<Args...> types;
 
-        LLC_CHECK(object != nullptr);
+        LLC_CHECK(target != nullptr);
 
         if constexpr (std::is_same<R, void>::value) {
             if constexpr (sizeof...(Args) == 0)
-                (object->value.*f)();
+                (target->value.*f)();
             else if constexpr (sizeof...(Args) == 1)
-                (object->value.*f)(args[0].as<decltype(types.template at<0>())>());
+                (target->value.*f)(args[0].as<decltype(types.template at<0>())>());
             else if constexpr (sizeof...(Args) == 2)
-                (object->value.*f)(args[0].as<decltype(types.template at<0>())>(),
+                (target->value.*f)(args[0].as<decltype(types.template at<0>())>(),
                                    args[1].as<decltype(types.template at<1>())>());
             else
                 throw_exception("too many arguments, only support <= 4");
 
         } else {
             if constexpr (sizeof...(Args) == 0)
-                return (Object)(object->value.*f)();
+                return (Object)(target->value.*f)();
             else if constexpr (sizeof...(Args) == 1)
-                return (Object)(object->value.*f)(args[0].as<decltype(types.template at<0>())>());
+                return (Object)(target->value.*f)(args[0].as<decltype(types.template at<0>())>());
             else if constexpr (sizeof...(Args) == 2)
-                return (Object)(object->value.*f)(args[0].as<decltype(types.template at<0>())>(),
+                return (Object)(target->value.*f)(args[0].as<decltype(types.template at<0>())>(),
                                                   args[1].as<decltype(types.template at<1>())>());
             else
                 throw_exception("too many arguments, only support <= 4");
@@ -913,15 +1371,6 @@ struct ConcreteMemberFunction : ExternalFunction {
     F f;
 };
 
-template <typename T>
-BaseObject* ConcreteObject<T>::clone() const {
-    ConcreteObject<T>* object = new ConcreteObject<T>(*this);
-    object->bind_members();
-    for (auto& f : object->functions)
-        dynamic_cast<ExternalFunction*>(f.second.base.get())->bind_object(object);
-    return object;
-}
-
 struct Function {
     Function() : base(nullptr){};
     Function(std::unique_ptr<BaseFunction> base) : base(std::move(base)) {
@@ -929,15 +1378,17 @@ struct Function {
     }
 
     Function(const Function& rhs) {
-        if (rhs.base != nullptr)
+        if (rhs.base != nullptr) {
             base.reset(rhs.base->clone());
+            CloneCounter::functions++;
+        }
     }
-    Function(Function&&) = default;
+    Function(Function&&) noexcept = default;
     Function& operator=(Function rhs) {
         swap(rhs);
         return *this;
     }
-    void swap(Function& rhs) {
+    void swap(Function& rhs) noexcept {
         std::swap(base, rhs.base);
     }
 
@@ -945,33 +1396,141 @@ struct Function {
         LLC_CHECK(base != nullptr);
         return base->run(scope, exprs);
     }
+    std::optional<Object> call(const Scope& scope, const std::vector<Object>& args) const {
+        LLC_CHECK(base != nullptr);
+        return base->call(scope, args);
+    }
+    std::optional<Object> run_method(const Scope& scope, const std::vector<Expression>& exprs,
+                                     BaseObject* self) const {
+        LLC_CHECK(base != nullptr);
+        return base->run_method(scope, exprs, self);
+    }
 
     std::unique_ptr<BaseFunction> base;
 };
 
+// methods are bound to an object the first time they are called on it
+template <typename T>
+Function* ConcreteObject<T>::find_function(const std::string& name) {
+    auto it = functions.find(name);
+    if (it != functions.end())
+        return &it->second;
+    int index = method_index(name);
+    if (index < 0)
+        return nullptr;
+    Function& function = functions[name] = info->methods[index];
+    dynamic_cast<ExternalFunction*>(function.base.get())->bind_object(this);
+    return &function;
+}
+
+// methods of structs are shared by their objects and run with the object as Frame::self
+inline Function* InternalObject::find_function(const std::string& name) {
+    int index = method_index(name);
+    return index < 0 ? nullptr : &info->methods[index];
+}
+
+enum class Flow { Normal, Break, Return, TailCall };
+
+// how a statement finished, "value" is the returned object for Flow::Return and the result of the
+// expression for expression statements
+struct Completion {
+    Completion() = default;
+    Completion(Flow flow, std::optional<Object>&& value = std::nullopt)
+        : flow(flow), value(std::move(value)) {
+    }
+    Completion(Completion&&) = default;
+    Completion& operator=(Completion&&) = default;
+
+    Flow flow = Flow::Normal;
+    std::optional<Object> value;
+};
+
+// the storage of one call of an internal function, "locals" holds the variables of every block of
+// the function body at their Scope::frame_offset and "self" is the object of a method
+struct Frame {
+    std::vector<Object> locals;
+    InternalObject* self = nullptr;
+    // the call left by a return in tail position for InternalFunction::call to run next
+    const InternalFunction* tail_function = nullptr;
+    std::vector<Object> tail_arguments;
+
+    static inline thread_local Frame* current = nullptr;
+};
+
+// where a resolved variable lives: in the frame of the running call, among the fields of the
+// object it runs a method of, or at a fixed place for variables outside of functions
+struct VariableRef {
+    explicit operator bool() const {
+        return local >= 0 || member >= 0 || object != nullptr;
+    }
+    bool operator==(const VariableRef& rhs) const {
+        return local == rhs.local && member == rhs.member && object == rhs.object;
+    }
+
+    Object& get() const {
+        if (local >= 0)
+            return Frame::current->locals[local];
+        if (member >= 0)
+            return Frame::current->self->fields[member];
+        return *object;
+    }
+
+    int local = -1;
+    int member = -1;
+    Object* object = nullptr;
+};
+
 struct Statement {
     virtual ~Statement() = default;
 
-    virtual std::optional<Object> run(const Scope& scope) const = 0;
+    virtual Completion run(const Scope& scope) const = 0;
+    // binds the variable references of the statement to their storage, see VariableOp
+    virtual void resolve(const Scope&) {
+    }
 };
 
 struct Scope : Statement {
-    Scope();
+    Completion run(const Scope& scope) const override;
+    void resolve(const Scope& scope) override;
 
-    std::optional<Object> run(const Scope& scope) const override;
-
-    std::optional<Object> find_type(const std::string& name) const;
-    std::optional<Object> find_variable(const std::string& name) const;
-    std::optional<Function> find_function(const std::string& name) const;
+    // lookups walk up the scopes and return nullptr when nothing is found
+    const Object* find_type(const std::string& name) const;
+    Object* find_variable(const std::string& name) const;
+    const Function* find_function(const std::string& name) const;
     Object& get_variable(const std::string& name) const;
 
+    // declares or redeclares a variable, returns its index in "variables"
+    int add_variable(const std::string& name, const Object& object);
+    // lays out the variables of a function definition and its nested blocks into "frame"
+    void allocate_frame();
+
     std::shared_ptr<Scope> parent;
     std::vector<std::shared_ptr<Statement>> statements;
+    std::shared_ptr<Statement> compiled;
+    // types declared in this scope, builtin_types() are found after every scope
     mutable std::unordered_map<std::string, Object> types;
-    mutable std::unordered_map<std::string, Object> variables;
+    mutable std::vector<Object> variables;
+    std::unordered_map<std::string, int> slots;
     mutable std::unordered_map<std::string, Function> functions;
+
+    // for function definitions, "variables" only serve as prototypes of the frame of each call
+    bool function = false;
+    int frame_offset = -1;
+    std::vector<Object> frame;
+    // for methods, the fields of the struct in the order of their offsets
+    std::vector<std::string> members;
 };
 
+// calls "visit" on "scope" and every block nested in it, without entering function definitions
+void for_each_block(Scope* scope, const std::function<void(Scope*)>& visit);
+
+// the types every program knows, shared by all scopes and never modified
+const std::unordered_map<std::string, Object>& builtin_types();
+
+// the program scope followed by the definition of every internal function reachable from it,
+// these are the scopes that get executed as a whole and thus are what engines lower
+std::vector<Scope*> collect_entry_scopes(Scope* scope);
+
 struct Operand {
     virtual ~Operand() = default;
 
@@ -990,10 +1549,21 @@ struct Operand {
         return {};
     }
 
+    virtual void resolve(const Scope&) {
+    }
+    // the type every evaluation results in as far as it is known after resolve(), see specialize
+    virtual size_t static_type() const {
+        return typeid_unknown;
+    }
+
     virtual int get_precedence() const = 0;
     virtual void set_precedence(int prec) = 0;
 };
 
+// replaces an operator whose operands have known types by a node specialized for them, returns
+// "operand" itself otherwise
+std::shared_ptr<Operand> specialize(const std::shared_ptr<Operand>& operand);
+
 struct BaseOp : Operand {
     std::vector<int> collapse(const std::vector<std::shared_ptr<Operand>>&, int) override {
         return {};
@@ -1009,6 +1579,12 @@ struct BinaryOp : Operand {
         b = operands[index + 1];
         return {index - 1, index + 1};
     }
+    void resolve(const Scope& scope) override {
+        a->resolve(scope);
+        b->resolve(scope);
+        a = specialize(a);
+        b = specialize(b);
+    }
 
     std::shared_ptr<Operand> a, b;
 };
@@ -1021,6 +1597,12 @@ struct PreUnaryOp : Operand {
         operand = operands[index + 1];
         return {index + 1};
     }
+    void resolve(const Scope& scope) override {
+        if (operand) {
+            operand->resolve(scope);
+            operand = specialize(operand);
+        }
+    }
 
     std::shared_ptr<Operand> operand;
 };
@@ -1033,15 +1615,24 @@ struct PostUnaryOp : Operand {
         operand = operands[index - 1];
         return {index - 1};
     }
+    void resolve(const Scope& scope) override {
+        if (operand) {
+            operand->resolve(scope);
+            operand = specialize(operand);
+        }
+    }
 
     std::shared_ptr<Operand> operand;
 };
 
 struct NumberLiteral : BaseOp {
-    NumberLiteral(float value) : value(value){};
+    NumberLiteral(Object value) : value(value){};
 
     Object evaluate(const Scope&) const override {
-        return Object(value);
+        return value;
+    }
+    size_t static_type() const override {
+        return value.type_id();
     }
 
     int get_precedence() const override {
@@ -1052,7 +1643,7 @@ struct NumberLiteral : BaseOp {
     }
 
     int precedence = 10;
-    float value;
+    Object value;
 };
 
 struct CharLiteral : BaseOp {
@@ -1061,6 +1652,9 @@ struct CharLiteral : BaseOp {
     Object evaluate(const Scope&) const override {
         return Object(value);
     }
+    size_t static_type() const override {
+        return typeid_char;
+    }
 
     int get_precedence() const override {
         return precedence;
@@ -1091,21 +1685,30 @@ struct StringLiteral : BaseOp {
     std::string value;
 };
 
+// refers to the variable bound by resolve(), before that(e.g. in struct bodies run while parsing)
+// it is looked up by name
 struct VariableOp : BaseOp {
     VariableOp(std::string name) : name(name){};
 
     Object evaluate(const Scope& scope) const override {
-        return scope.get_variable(name);
+        return original(scope);
     }
 
     Object assign(const Scope& scope, const Object& value) override {
-        auto& object = scope.get_variable(name);
+        auto& object = original(scope);
         object.assign(value);
         return object;
     }
 
     Object& original(const Scope& scope) const override {
-        return scope.get_variable(name);
+        if (!ref)
+            return scope.get_variable(name);
+        return ref.get();
+    }
+
+    void resolve(const Scope& scope) override;
+    size_t static_type() const override {
+        return type;
     }
 
     int get_precedence() const override {
@@ -1116,6 +1719,9 @@ struct VariableOp : BaseOp {
     }
     int precedence = 10;
     std::string name;
+    VariableRef ref;
+    // variables keep the type they are declared with, assignments convert to it
+    size_t type = typeid_unknown;
 };
 
 struct ObjectMember : Operand {
@@ -1138,6 +1744,26 @@ struct ObjectMember : Operand {
     std::string name;
 };
 
+// the index of a member or method for the type of the objects a call site saw last, so that
+// repeated accesses skip the lookup by name. the type and the index share one word as the same
+// program may run on several threads
+struct InlineCache {
+    InlineCache() = default;
+    InlineCache(const InlineCache& rhs) : entry(rhs.entry.load(std::memory_order_relaxed)) {
+    }
+
+    // returns the index cached for "type", or -1 on a miss
+    int find(size_t type) const {
+        uint64_t cached = entry.load(std::memory_order_relaxed);
+        return (cached >> 32) == type + 1 ? (int)(uint32_t)cached : -1;
+    }
+    void store(size_t type, int index) const {
+        entry.store((uint64_t(type + 1) << 32) | (uint32_t)index, std::memory_order_relaxed);
+    }
+
+    mutable std::atomic<uint64_t> entry{0};
+};
+
 struct MemberAccess : BinaryOp {
     std::vector<int> collapse(const std::vector<std::shared_ptr<Operand>>& operands,
                               int index) override {
@@ -1145,25 +1771,24 @@ struct MemberAccess : BinaryOp {
         LLC_CHECK(index + 1 < (int)operands.size());
         a = operands[index - 1];
         b = operands[index + 1];
+        auto member = dynamic_cast<ObjectMember*>(b.get());
+        LLC_CHECK(member != nullptr);
+        member_name = member->name;
         return {index - 1, index + 1};
     }
 
     Object evaluate(const Scope& scope) const override {
-        auto member = dynamic_cast<ObjectMember*>(b.get());
-        LLC_CHECK(member != nullptr);
-        return a->original(scope)[member->name];
+        return member_of(a->original(scope));
     }
     Object& original(const Scope& scope) const override {
-        auto member = dynamic_cast<ObjectMember*>(b.get());
-        LLC_CHECK(member != nullptr);
-        return a->original(scope)[member->name];
+        return member_of(a->original(scope));
     }
     Object assign(const Scope& scope, const Object& value) override {
-        auto member = dynamic_cast<ObjectMember*>(b.get());
-        LLC_CHECK(member != nullptr);
-        a->original(scope)[member->name].assign(value);
-        return a->original(scope)[member->name];
+        Object& member = member_of(a->original(scope));
+        member.assign(value);
+        return member;
     }
+    Object& member_of(Object& object) const;
 
     int get_precedence() const override {
         return precedence;
@@ -1172,10 +1797,13 @@ struct MemberAccess : BinaryOp {
         precedence = prec;
     }
     int precedence = 10;
+    std::string member_name;
+    InlineCache cache;
 };
 
 struct MemberFunctionCall : PostUnaryOp {
     Object evaluate(const Scope& scope) const override;
+    void resolve(const Scope& scope) override;
     Object assign(const Scope&, const Object&) override {
         throw_exception("cannot assign a member function");
         return {};
@@ -1191,6 +1819,7 @@ struct MemberFunctionCall : PostUnaryOp {
 
     std::string function_name;
     std::vector<Expression> arguments;
+    InlineCache cache;
 };
 
 struct ArrayAccess : BinaryOp {
@@ -1219,6 +1848,10 @@ struct TypeOp : BaseOp {
     TypeOp(Object type) : type(type){};
 
     Object evaluate(const Scope& scope) const override;
+    void resolve(const Scope& scope) override;
+    size_t static_type() const override {
+        return type.is_void() ? typeid_unknown : type.type_id();
+    }
 
     int get_precedence() const override {
         return precedence;
@@ -1251,6 +1884,9 @@ struct Assignment : BinaryOp {
     Object evaluate(const Scope& scope) const override {
         return a->assign(scope, b->evaluate(scope));
     }
+    size_t static_type() const override {
+        return a->static_type();
+    }
 
     int get_precedence() const override {
         return precedence;
@@ -1263,7 +1899,20 @@ struct Assignment : BinaryOp {
 
 struct Addition : BinaryOp {
     Object evaluate(const Scope& scope) const override {
-        return a->evaluate(scope) + b->evaluate(scope);
+        Object lhs = a->evaluate(scope);
+        return apply(std::move(lhs), b->evaluate(scope));
+    }
+    size_t static_type() const override {
+        return a->static_type();
+    }
+
+    static Object apply(Object lhs, const Object& rhs) {
+        lhs += rhs;
+        return lhs;
+    }
+    template <typename T>
+    static T apply(T lhs, T rhs) {
+        return lhs + rhs;
     }
 
     int get_precedence() const override {
@@ -1277,7 +1926,20 @@ struct Addition : BinaryOp {
 
 struct Subtrbody : BinaryOp {
     Object evaluate(const Scope& scope) const override {
-        return a->evaluate(scope) - b->evaluate(scope);
+        Object lhs = a->evaluate(scope);
+        return apply(std::move(lhs), b->evaluate(scope));
+    }
+    size_t static_type() const override {
+        return a->static_type();
+    }
+
+    static Object apply(Object lhs, const Object& rhs) {
+        lhs -= rhs;
+        return lhs;
+    }
+    template <typename T>
+    static T apply(T lhs, T rhs) {
+        return lhs - rhs;
     }
 
     int get_precedence() const override {
@@ -1291,7 +1953,20 @@ struct Subtrbody : BinaryOp {
 
 struct Multiplication : BinaryOp {
     Object evaluate(const Scope& scope) const override {
-        return a->evaluate(scope) * b->evaluate(scope);
+        Object lhs = a->evaluate(scope);
+        return apply(std::move(lhs), b->evaluate(scope));
+    }
+    size_t static_type() const override {
+        return a->static_type();
+    }
+
+    static Object apply(Object lhs, const Object& rhs) {
+        lhs *= rhs;
+        return lhs;
+    }
+    template <typename T>
+    static T apply(T lhs, T rhs) {
+        return lhs * rhs;
     }
 
     int get_precedence() const override {
@@ -1305,7 +1980,20 @@ struct Multiplication : BinaryOp {
 
 struct Division : BinaryOp {
     Object evaluate(const Scope& scope) const override {
-        return a->evaluate(scope) / b->evaluate(scope);
+        Object lhs = a->evaluate(scope);
+        return apply(std::move(lhs), b->evaluate(scope));
+    }
+    size_t static_type() const override {
+        return a->static_type();
+    }
+
+    static Object apply(Object lhs, const Object& rhs) {
+        lhs /= rhs;
+        return lhs;
+    }
+    template <typename T>
+    static T apply(T lhs, T rhs) {
+        return lhs / rhs;
     }
 
     int get_precedence() const override {
@@ -1321,6 +2009,17 @@ struct AddEqual : BinaryOp {
     Object evaluate(const Scope& scope) const override {
         return a->original(scope) += b->evaluate(scope);
     }
+    size_t static_type() const override {
+        return a->static_type();
+    }
+
+    static Object apply(Object& lhs, const Object& rhs) {
+        return lhs += rhs;
+    }
+    template <typename T>
+    static T apply(T& lhs, T rhs) {
+        return lhs += rhs;
+    }
 
     int get_precedence() const override {
         return precedence;
@@ -1335,6 +2034,17 @@ struct SubtractEqual : BinaryOp {
     Object evaluate(const Scope& scope) const override {
         return a->original(scope) -= b->evaluate(scope);
     }
+    size_t static_type() const override {
+        return a->static_type();
+    }
+
+    static Object apply(Object& lhs, const Object& rhs) {
+        return lhs -= rhs;
+    }
+    template <typename T>
+    static T apply(T& lhs, T rhs) {
+        return lhs -= rhs;
+    }
 
     int get_precedence() const override {
         return precedence;
@@ -1349,6 +2059,17 @@ struct MultiplyEqual : BinaryOp {
     Object evaluate(const Scope& scope) const override {
         return a->original(scope) *= b->evaluate(scope);
     }
+    size_t static_type() const override {
+        return a->static_type();
+    }
+
+    static Object apply(Object& lhs, const Object& rhs) {
+        return lhs *= rhs;
+    }
+    template <typename T>
+    static T apply(T& lhs, T rhs) {
+        return lhs *= rhs;
+    }
 
     int get_precedence() const override {
         return precedence;
@@ -1363,6 +2084,17 @@ struct DivideEqual : BinaryOp {
     Object evaluate(const Scope& scope) const override {
         return a->original(scope) /= b->evaluate(scope);
     }
+    size_t static_type() const override {
+        return a->static_type();
+    }
+
+    static Object apply(Object& lhs, const Object& rhs) {
+        return lhs /= rhs;
+    }
+    template <typename T>
+    static T apply(T& lhs, T rhs) {
+        return lhs /= rhs;
+    }
 
     int get_precedence() const override {
         return precedence;
@@ -1380,6 +2112,14 @@ struct PostIncrement : PostUnaryOp {
         operand->assign(scope, ++temp);
         return old;
     }
+    size_t static_type() const override {
+        return operand->static_type();
+    }
+
+    template <typename T>
+    static T apply(T& value) {
+        return value++;
+    }
 
     int get_precedence() const override {
         return precedence;
@@ -1398,6 +2138,14 @@ struct PostDecrement : PostUnaryOp {
         operand->assign(scope, --temp);
         return old;
     }
+    size_t static_type() const override {
+        return operand->static_type();
+    }
+
+    template <typename T>
+    static T apply(T& value) {
+        return value--;
+    }
 
     int get_precedence() const override {
         return precedence;
@@ -1413,6 +2161,14 @@ struct PreIncrement : PreUnaryOp {
     Object evaluate(const Scope& scope) const override {
         return operand->assign(scope, ++operand->evaluate(scope));
     }
+    size_t static_type() const override {
+        return operand->static_type();
+    }
+
+    template <typename T>
+    static T apply(T& value) {
+        return ++value;
+    }
 
     int get_precedence() const override {
         return precedence;
@@ -1428,6 +2184,14 @@ struct PreDecrement : PreUnaryOp {
     Object evaluate(const Scope& scope) const override {
         return operand->assign(scope, --operand->evaluate(scope));
     }
+    size_t static_type() const override {
+        return operand->static_type();
+    }
+
+    template <typename T>
+    static T apply(T& value) {
+        return --value;
+    }
 
     int get_precedence() const override {
         return precedence;
@@ -1443,6 +2207,9 @@ struct Negation : PreUnaryOp {
     Object evaluate(const Scope& scope) const override {
         return -operand->evaluate(scope);
     }
+    size_t static_type() const override {
+        return operand->static_type();
+    }
 
     int get_precedence() const override {
         return precedence;
@@ -1456,7 +2223,19 @@ struct Negation : PreUnaryOp {
 
 struct LessThan : BinaryOp {
     Object evaluate(const Scope& scope) const override {
-        return Object(a->evaluate(scope) < b->evaluate(scope));
+        Object lhs = a->evaluate(scope);
+        return apply(lhs, b->evaluate(scope));
+    }
+    size_t static_type() const override {
+        return typeid_bool;
+    }
+
+    static Object apply(const Object& lhs, const Object& rhs) {
+        return Object(lhs < rhs);
+    }
+    template <typename T>
+    static bool apply(T lhs, T rhs) {
+        return lhs < rhs;
     }
 
     int get_precedence() const override {
@@ -1470,7 +2249,19 @@ struct LessThan : BinaryOp {
 
 struct LessEqual : BinaryOp {
     Object evaluate(const Scope& scope) const override {
-        return Object(a->evaluate(scope) <= b->evaluate(scope));
+        Object lhs = a->evaluate(scope);
+        return apply(lhs, b->evaluate(scope));
+    }
+    size_t static_type() const override {
+        return typeid_bool;
+    }
+
+    static Object apply(const Object& lhs, const Object& rhs) {
+        return Object(lhs <= rhs);
+    }
+    template <typename T>
+    static bool apply(T lhs, T rhs) {
+        return lhs <= rhs;
     }
 
     int get_precedence() const override {
@@ -1484,7 +2275,19 @@ struct LessEqual : BinaryOp {
 
 struct GreaterThan : BinaryOp {
     Object evaluate(const Scope& scope) const override {
-        return Object(a->evaluate(scope) > b->evaluate(scope));
+        Object lhs = a->evaluate(scope);
+        return apply(lhs, b->evaluate(scope));
+    }
+    size_t static_type() const override {
+        return typeid_bool;
+    }
+
+    static Object apply(const Object& lhs, const Object& rhs) {
+        return Object(lhs > rhs);
+    }
+    template <typename T>
+    static bool apply(T lhs, T rhs) {
+        return lhs > rhs;
     }
 
     int get_precedence() const override {
@@ -1498,7 +2301,19 @@ struct GreaterThan : BinaryOp {
 
 struct GreaterEqual : BinaryOp {
     Object evaluate(const Scope& scope) const override {
-        return Object(a->evaluate(scope) >= b->evaluate(scope));
+        Object lhs = a->evaluate(scope);
+        return apply(lhs, b->evaluate(scope));
+    }
+    size_t static_type() const override {
+        return typeid_bool;
+    }
+
+    static Object apply(const Object& lhs, const Object& rhs) {
+        return Object(lhs >= rhs);
+    }
+    template <typename T>
+    static bool apply(T lhs, T rhs) {
+        return lhs >= rhs;
     }
 
     int get_precedence() const override {
@@ -1512,7 +2327,19 @@ struct GreaterEqual : BinaryOp {
 
 struct Equal : BinaryOp {
     Object evaluate(const Scope& scope) const override {
-        return Object(a->evaluate(scope) == b->evaluate(scope));
+        Object lhs = a->evaluate(scope);
+        return apply(lhs, b->evaluate(scope));
+    }
+    size_t static_type() const override {
+        return typeid_bool;
+    }
+
+    static Object apply(const Object& lhs, const Object& rhs) {
+        return Object(lhs == rhs);
+    }
+    template <typename T>
+    static bool apply(T lhs, T rhs) {
+        return lhs == rhs;
     }
 
     int get_precedence() const override {
@@ -1526,7 +2353,19 @@ struct Equal : BinaryOp {
 
 struct NotEqual : BinaryOp {
     Object evaluate(const Scope& scope) const override {
-        return Object(a->evaluate(scope) != b->evaluate(scope));
+        Object lhs = a->evaluate(scope);
+        return apply(lhs, b->evaluate(scope));
+    }
+    size_t static_type() const override {
+        return typeid_bool;
+    }
+
+    static Object apply(const Object& lhs, const Object& rhs) {
+        return Object(lhs != rhs);
+    }
+    template <typename T>
+    static bool apply(T lhs, T rhs) {
+        return lhs != rhs;
     }
 
     int get_precedence() const override {
@@ -1538,6 +2377,54 @@ struct NotEqual : BinaryOp {
     int precedence = 2;
 };
 
+// "a op b" for operands of the arithmetic types T and U inferred by specialize(), "b" is
+// converted to T like the generic operators do. the generic operator of "Node" still handles
+// evaluations where an operand does not have the inferred type, e.g. a function without return
+template <typename Node, typename T, typename U>
+struct Specialized : Node {
+    Specialized(const Node& node) : Node(node) {
+    }
+
+    Object evaluate(const Scope& scope) const override {
+        Object lhs = this->a->evaluate(scope);
+        Object rhs = this->b->evaluate(scope);
+        if (lhs.kind == Object::kind_of<T>() && rhs.kind == Object::kind_of<U>())
+            return Object(Node::apply(lhs.unboxed<T>(), T(rhs.unboxed<U>())));
+        return Node::apply(std::move(lhs), rhs);
+    }
+};
+
+// "a op= b" on a variable "a" of the arithmetic type T, updated in place. "b" of type U is
+// evaluated first and converted to T like the generic operators do
+template <typename Node, typename T, typename U>
+struct SpecializedAssignment : Node {
+    SpecializedAssignment(const Node& node) : Node(node) {
+    }
+
+    Object evaluate(const Scope& scope) const override {
+        Object rhs = this->b->evaluate(scope);
+        Object& lhs = this->a->original(scope);
+        if (lhs.kind == Object::kind_of<T>() && rhs.kind == Object::kind_of<U>())
+            return Object(Node::apply(lhs.unboxed<T>(), T(rhs.unboxed<U>())));
+        return Node::apply(lhs, rhs);
+    }
+};
+
+// "++a", "a--" and the like on a variable of the arithmetic type T, updated in place instead of
+// through a copy that is assigned back
+template <typename Node, typename T>
+struct SpecializedUpdate : Node {
+    SpecializedUpdate(const Node& node) : Node(node) {
+    }
+
+    Object evaluate(const Scope& scope) const override {
+        Object& value = this->operand->original(scope);
+        if (value.kind == Object::kind_of<T>())
+            return Object(Node::apply(value.unboxed<T>()));
+        return Node::evaluate(scope);
+    }
+};
+
 struct LeftParenthese : Operand {
     std::vector<int> collapse(const std::vector<std::shared_ptr<Operand>>&, int) override {
         throw_exception("LeftParenthese::collapse() shall not be called");
@@ -1613,20 +2500,30 @@ struct Expression : Statement {
         return operands[0]->evaluate(scope);
     }
 
-    std::optional<Object> run(const Scope& scope) const override {
-        return this->operator()(scope);
+    Completion run(const Scope& scope) const override {
+        return {Flow::Normal, this->operator()(scope)};
+    }
+    void resolve(const Scope& scope) override {
+        for (auto& operand : operands) {
+            operand->resolve(scope);
+            operand = specialize(operand);
+        }
     }
 
     std::vector<std::shared_ptr<Operand>> operands;
 };
 
 struct FunctionCall : Statement {
-    std::optional<Object> run(const Scope& scope) const override {
+    Completion run(const Scope& scope) const override {
         if (auto func = scope.find_function(function_name))
-            return func->run(scope, arguments);
+            return {Flow::Normal, func->run(scope, arguments)};
         else
             throw_exception("cannot find function \"", function_name, '"');
-        return std::nullopt;
+        return {};
+    }
+    void resolve(const Scope& scope) override {
+        for (auto& argument : arguments)
+            argument.resolve(scope);
     }
 
     std::string function_name;
@@ -1637,10 +2534,18 @@ struct FunctionCallOp : BaseOp {
     FunctionCallOp(FunctionCall function) : function(function){};
 
     Object evaluate(const Scope& scope) const override {
-        if (auto result = function.run(scope))
-            return *result;
-        throw_exception("function returns void, which cannnot appear in expression");
-        return {};
+        if (auto result = function.run(scope).value)
+            return std::move(*result);
+        else
+            return {};
+    }
+    void resolve(const Scope& scope) override {
+        function.resolve(scope);
+        const Function* callee = scope.find_function(function.function_name);
+        type = callee && callee->base ? callee->base->return_type_id() : typeid_unknown;
+    }
+    size_t static_type() const override {
+        return type;
     }
 
     int get_precedence() const override {
@@ -1652,24 +2557,26 @@ struct FunctionCallOp : BaseOp {
 
     int precedence = 10;
     FunctionCall function;
+    size_t type = typeid_unknown;
 };
 
+// the internal function a return in tail position can replace the running call with, or nullptr
+const InternalFunction* tail_callee(const Function* function);
+
 struct Return : Statement {
     Return(Expression expression) : expression(expression){};
 
-    std::optional<Object> run(const Scope& scope) const override {
-        auto result = expression(scope);
-        throw result;
-        return result;
-    }
+    Completion run(const Scope& scope) const override;
+    void resolve(const Scope& scope) override;
 
     Expression expression;
+    // set for "return f(...)" inside a function
+    const FunctionCall* tail_call = nullptr;
 };
 
 struct Break : Statement {
-    std::optional<Object> run(const Scope&) const override {
-        throw BreakLoop();
-        return std::nullopt;
+    Completion run(const Scope&) const override {
+        return {Flow::Break};
     }
 };
 
@@ -1677,12 +2584,99 @@ struct IfElseChain : Statement {
     IfElseChain(std::vector<Expression> conditions, std::vector<std::shared_ptr<Scope>> bodys)
         : conditions(conditions), bodys(bodys){};
 
-    std::optional<Object> run(const Scope& scope) const override;
+    Completion run(const Scope& scope) const override;
+    void resolve(const Scope& scope) override;
 
     std::vector<Expression> conditions;
     std::vector<std::shared_ptr<Scope>> bodys;
 };
 
+// the shape of "for (...; i < limit; ++i)": an int or int64_t counter "i" compared to a literal or
+// to a variable of the same type, and stepped by "++", "--", "+= k" or "-= k" with a literal "k".
+// assignments convert to the type of a variable, so the counter and the limit keep the type they
+// have when the loop starts
+struct CountedLoop {
+    enum class Compare : uint8_t { LessThan, LessEqual, GreaterThan, GreaterEqual, NotEqual };
+
+    // runs "body" while the condition holds and until it returns false, with the counter compared
+    // and stepped in place. returns false without running anything when the counter or the limit
+    // does not have the type of the counter
+    template <typename Body>
+    bool run(Body& body) const {
+        Object& value = counter.get();
+        Object& bound = limit.get();
+        if (value.kind != kind || bound.kind != kind)
+            return false;
+        if (kind == Object::Kind::Int)
+            run(value.unboxed<int>(), bound.unboxed<int>(), body);
+        else
+            run(value.unboxed<int64_t>(), bound.unboxed<int64_t>(), body);
+        return true;
+    }
+
+    // the condition, and the updation followed by the condition, for engines that lower the loop
+    // themselves. nullopt when the counter or the limit does not have the type of the counter
+    std::optional<bool> test() const {
+        return iteration<false>();
+    }
+    std::optional<bool> next() const {
+        return iteration<true>();
+    }
+
+    VariableRef counter, limit;
+    // the value of a literal limit, converted to the type of the counter. "limit" refers to it
+    std::shared_ptr<Object> constant;
+    Object::Kind kind = Object::Kind::Int;
+    Compare compare = Compare::LessThan;
+    int64_t step = 1;
+
+  private:
+    template <bool advance>
+    std::optional<bool> iteration() const {
+        Object& value = counter.get();
+        Object& bound = limit.get();
+        if (value.kind != kind || bound.kind != kind)
+            return std::nullopt;
+        if (kind == Object::Kind::Int)
+            return iteration<advance>(value.unboxed<int>(), bound.unboxed<int>());
+        return iteration<advance>(value.unboxed<int64_t>(), bound.unboxed<int64_t>());
+    }
+    template <bool advance, typename T>
+    bool iteration(T& value, T bound) const {
+        if constexpr (advance)
+            value += T(step);
+        return holds(value, bound);
+    }
+    template <typename T>
+    bool holds(T lhs, T rhs) const {
+        switch (compare) {
+        case Compare::LessThan: return lhs < rhs;
+        case Compare::LessEqual: return lhs <= rhs;
+        case Compare::GreaterThan: return lhs > rhs;
+        case Compare::GreaterEqual: return lhs >= rhs;
+        default: return lhs != rhs;
+        }
+    }
+
+    // the comparison is chosen once, outside of the loop
+    template <typename T, typename Body>
+    void run(T& value, const T& bound, Body& body) const {
+        switch (compare) {
+        case Compare::LessThan: return run(value, bound, body, std::less<T>());
+        case Compare::LessEqual: return run(value, bound, body, std::less_equal<T>());
+        case Compare::GreaterThan: return run(value, bound, body, std::greater<T>());
+        case Compare::GreaterEqual: return run(value, bound, body, std::greater_equal<T>());
+        default: return run(value, bound, body, std::not_equal_to<T>());
+        }
+    }
+    template <typename T, typename Body, typename Holds>
+    void run(T& value, const T& bound, Body& body, Holds holds) const {
+        for (T increment = T(step); holds(value, bound); value += increment)
+            if (!body())
+                return;
+    }
+};
+
 struct For : Statement {
     For(Expression initialization, Expression condition, Expression updation,
         std::shared_ptr<Scope> internal_scope, std::shared_ptr<Scope> body)
@@ -1692,16 +2686,46 @@ struct For : Statement {
           internal_scope(internal_scope),
           body(body){};
 
-    std::optional<Object> run(const Scope& scope) const override;
+    Completion run(const Scope& scope) const override;
+    void resolve(const Scope& scope) override;
+
+    // runs the iterations of the loop once it is initialized, until the condition fails or
+    // "body" returns false
+    template <typename Body>
+    void iterate(Body&& body) const {
+        if (counted && counted->run(body))
+            return;
+        for (bool holds = test(); holds; holds = next())
+            if (!body())
+                return;
+    }
+    // the condition, and the updation followed by the condition, those of a counted loop are run
+    // in place
+    bool test() const {
+        if (counted)
+            if (std::optional<bool> holds = counted->test())
+                return *holds;
+        return condition.operands.empty() || condition(*internal_scope)->as<bool>();
+    }
+    bool next() const {
+        if (counted)
+            if (std::optional<bool> holds = counted->next())
+                return *holds;
+        updation(*internal_scope);
+        return test();
+    }
 
     Expression initialization, condition, updation;
     std::shared_ptr<Scope> internal_scope, body;
+    // set by resolve() when the loop is a counted loop
+    std::optional<CountedLoop> counted;
 };
 
 struct While : Statement {
     While(Expression condition, std::shared_ptr<Scope> body) : condition(condition), body(body){};
 
-    std::optional<Object> run(const Scope& scope) const override;
+    Completion run(const Scope& scope) const override;
+    void resolve(const Scope& scope) override;
 
     Expression condition;
     std::shared_ptr<Scope> body;
@@ -1712,12 +2736,17 @@ struct Program {
     void bind(std::string name, Return (*func)(Args...)) {
         functions[name] = (Function)std::make_unique<ConcreteFunction<Return, Args...>>(func);
     }
+    // for functions whose result only depends on their arguments and that have no side effect
+    template <typename Return, typename... Args>
+    void bind_pure(std::string name, Return (*func)(Args...)) {
+        bind(name, func);
+        functions[name].base->pure = true;
+    }
     template <typename T, typename = typename std::enable_if_t<!std::is_function_v<T>>>
     void bind(std::string name, const T& var) {
         using Ty = std::decay_t<T>;
         if constexpr (std::is_pointer_v<Ty>)
-            type_id_to_name[typeid(Ty).hash_code()] =
-                get_type_name<decltype(*(std::declval<Ty>()))>() + "*";
+            set_type_name<Ty>(get_type_name<decltype(*(std::declval<Ty>()))>() + "*");
         variables[name] = Object(Ty(var));
     }
 
@@ -1725,19 +2754,21 @@ struct Program {
     struct TypeBindHelper {
         TypeBindHelper(std::string type_name, std::map<std::string, Object>& types)
             : type_name(type_name), types(types) {
-            type_id_to_name[typeid(T).hash_code()] = type_name;
-            object = std::make_unique<ConcreteObject<T>>(T());
+            set_type_name<T>(type_name);
+            info = std::make_shared<TypeInfo<T>>();
+            info->name = type_name;
         };
         ~TypeBindHelper() {
-            object->bind_members();
-            types[type_name] = Object(std::move(object));
+            types[type_name] = Object(std::make_unique<ConcreteObject<T>>(T(), info));
         }
 
         template <typename M,
                   typename = typename std::enable_if_t<!std::is_member_function_pointer_v<M T::*>>>
         TypeBindHelper& bind(std::string id, M T::*ptr) {
-            using U = typename ConcreteObject<T>::template ConcreteAccessor<M>;
-            object->accessors[id] = std::make_shared<U>(ptr);
+            using U = typename TypeInfo<T>::template ConcreteAccessor<M>;
+            TypeInfo<T>::add(info->accessors, info->accessor_indices, id,
+                             std::shared_ptr<typename TypeInfo<T>::Accessor>(
+                                 std::make_shared<U>(ptr)));
             return *this;
         }
         template <typename F>
@@ -1745,42 +2776,50 @@ struct Program {
             bind_func_impl(id, func);
             return *this;
         }
+        // for methods whose result only depends on their arguments and the object and that
+        // modify neither
+        template <typename F>
+        TypeBindHelper& bind_pure(std::string id, F&& func) {
+            bind_func_impl(id, func);
+            info->methods[info->method_indices[id]].base->pure = true;
+            return *this;
+        }
 
         template <typename... Args>
         TypeBindHelper& ctor() {
-            using U = typename ConcreteObject<T>::template ConcreteConstructor<Args...>;
-            object->constructors.push_back(std::make_shared<U>());
+            using U = typename TypeInfo<T>::template ConcreteConstructor<Args...>;
+            info->constructors.push_back(std::make_shared<U>());
             return *this;
         }
 
       private:
         template <typename R = void, typename... Args>
         void bind_func_impl(std::string id, R (T::*func)(Args...)) {
-            object->functions[id] =
-                (Function)std::make_unique<ConcreteMemberFunction<T, R, Args...>>(
-                    object.get(), (R(T::*)(Args...))func);
+            add_method(id, std::make_unique<ConcreteMemberFunction<T, R, Args...>>(
+                               nullptr, (R(T::*)(Args...))func));
         }
         template <typename R = void, typename... Args>
         void bind_func_impl(std::string id, R (T::*func)(Args...) const) {
-            object->functions[id] =
-                (Function)std::make_unique<ConcreteMemberFunction<T, R, Args...>>(
-                    object.get(), (R(T::*)(Args...))func);
+            add_method(id, std::make_unique<ConcreteMemberFunction<T, R, Args...>>(
+                               nullptr, (R(T::*)(Args...))func));
         }
         template <typename R = void, typename... Args>
         void bind_func_impl(std::string id, R (T::*func)(Args...) &) {
-            object->functions[id] =
-                (Function)std::make_unique<ConcreteMemberFunction<T, R, Args...>>(
-                    object.get(), (R(T::*)(Args...))func);
+            add_method(id, std::make_unique<ConcreteMemberFunction<T, R, Args...>>(
+                               nullptr, (R(T::*)(Args...))func));
         }
         template <typename R = void, typename... Args>
         void bind_func_impl(std::string id, R (T::*func)(Args...) const&) {
-            object->functions[id] =
-                (Function)std::make_unique<ConcreteMemberFunction<T, R, Args...>>(
-                    object.get(), (R(T::*)(Args...))func);
+            add_method(id, std::make_unique<ConcreteMemberFunction<T, R, Args...>>(
+                               nullptr, (R(T::*)(Args...))func));
+        }
+
+        void add_method(const std::string& id, std::unique_ptr<BaseFunction> method) {
+            TypeInfo<T>::add(info->methods, info->method_indices, id, Function(std::move(method)));
         }
 
         std::string type_name;
-        std::unique_ptr<ConcreteObject<T>> object;
+        std::shared_ptr<TypeInfo<T>> info;
         std::map<std::string, Object>& types;
     };
 
@@ -1790,21 +2829,26 @@ struct Program {
     }
     template <typename T, typename = typename std::enable_if_t<std::is_pointer_v<T>>>
     void bind(std::string name) {
-        type_id_to_name[typeid(T).hash_code()] = name;
+        set_type_name<T>(name);
     }
 
+    // what the previous run allocated with "new" is released first, pointers to it must not be
+    // kept across runs
     void run() {
-        try {
-            scope->run(*scope);
-        } catch (const std::optional<Object>&) {
-        }
+        heap->release();
+        Heap::Use use(*heap);
+        size_t clones = CloneCounter::total();
+        Arena::Stats arena = Arena::stats();
+        scope->run(*scope);
+        last_run_clones = CloneCounter::total() - clones;
+        last_run_arena = Arena::stats() - arena;
     }
 
     struct Proxy {
         Proxy() = default;
         Proxy(std::shared_ptr<Scope> scope, Object& object) : scope(scope), object(&object) {
         }
-        Proxy(std::shared_ptr<Scope> scope, Function func) : scope(scope), func(func) {
+        Proxy(std::shared_ptr<Scope> scope, const Function& func) : scope(scope), func(&func) {
         }
 
         template <typename T>
@@ -1853,47 +2897,69 @@ struct Program {
 
         template <typename... Args>
         Object operator()(Args... args) const {
-            LLC_CHECK(object == nullptr);
+            LLC_CHECK(func != nullptr);
 
             std::vector<Expression> exprs;
             if constexpr (sizeof...(args) != 0)
                 expr_helper(exprs, args...);
-            auto object = func.run(*scope, exprs);
+            std::optional<Heap::Use> use;
+            if (heap != nullptr)
+                use.emplace(*heap);
+            auto object = func->run_method(*scope, exprs, self);
             if (object.has_value())
-                return *object;
+                return std::move(*object);
             else
                 return {};
         }
 
         Proxy operator[](std::string name) {
             LLC_CHECK(object != nullptr);
-            if (object->base->members.find(name) != object->base->members.end())
-                return Proxy(scope, object->base->members[name]);
-
-            LLC_CHECK(object->base->functions.find(name) != object->base->functions.end());
-            return Proxy(scope, object->base->functions[name]);
+            LLC_CHECK(object->base != nullptr);
+            if (Function* function = object->base->find_function(name)) {
+                Proxy method(scope, *function);
+                method.self = object->base.get();
+                method.heap = heap;
+                return method;
+            }
+            Proxy member(scope, object->base->get_member(name));
+            member.heap = heap;
+            return member;
         }
 
         std::shared_ptr<Scope> scope = nullptr;
+        std::shared_ptr<Heap> heap = nullptr;
         Object* object = nullptr;
-        Function func;
+        const Function* func = nullptr;
+        BaseObject* self = nullptr;
     };
 
     Proxy operator[](std::string name) const {
-        if (scope->find_variable(name))
-            return Proxy(scope, scope->variables[name]);
-        else if (scope->find_function(name))
-            return Proxy(scope, scope->functions[name]);
+        Proxy proxy;
+        if (Object* object = scope->find_variable(name))
+            proxy = Proxy(scope, *object);
+        else if (const Function* function = scope->find_function(name))
+            proxy = Proxy(scope, *function);
         else
             throw_exception('"', name, " is neither a function nor a variable");
-        return {};
+        proxy.heap = heap;
+        return proxy;
+    }
+
+    // what the script allocated with "new" since the last run() started
+    Heap::Stats heap_stats() const {
+        return heap->stats();
     }
 
     std::string source;
     std::string filepath;
+    // deep copies of objects and functions made by the last call to run() on this thread
+    size_t last_run_clones = 0;
+    // blocks and scratch vectors taken from the arena by the last call to run() on this thread
+    Arena::Stats last_run_arena;
 
   private:
     std::shared_ptr<Scope> scope;
+    std::shared_ptr<Heap> heap = std::make_shared<Heap>();
     std::map<std::string, Function> functions;
     std::map<std::string, Object> types;
     std::map<std::string, Object> variables;
@@ -0,0 +1,99 @@
+#ifndef LLC_VM_H
+#define LLC_VM_H
+
+#include <llc/defines.h>
+#include <llc/types.h>
+
+namespace llc {
+
+enum class OpCode : uint8_t {
+    Constant,
+    Load,
+    Store,
+    Pop,
+    Add,
+    Subtract,
+    Multiply,
+    Divide,
+    Negate,
+    LessThan,
+    LessEqual,
+    GreaterThan,
+    GreaterEqual,
+    Equal,
+    NotEqual,
+    AddEqual,
+    SubtractEqual,
+    MultiplyEqual,
+    DivideEqual,
+    Increment,
+    Decrement,
+    Call,
+    Evaluate,
+    Run,
+    Jump,
+    JumpIfFalse,
+    // the condition of a counted loop, see For::counted, and its updation followed by the
+    // condition, jumping back to the body while it holds
+    LoopTest,
+    LoopNext,
+    Return,
+    ReturnVoid,
+    TailCall
+};
+
+struct Instruction {
+    OpCode op;
+    int a = 0;
+    int b = 0;
+};
+
+// a linear lowering of one entry scope(program or function body), operands of instructions
+// index into the tables below, everything is resolved once when the chunk is built
+struct Chunk {
+    std::vector<Instruction> code;
+    std::vector<Object> constants;
+    std::vector<VariableRef> variables;
+    std::vector<std::pair<const Function*, const Scope*>> functions;
+    std::vector<std::pair<std::shared_ptr<Operand>, const Scope*>> operands;
+    std::vector<std::pair<std::shared_ptr<Statement>, const Scope*>> statements;
+    std::vector<const For*> loops;
+    int max_stack = 0;
+};
+
+struct Bytecode : Statement {
+    Completion run(const Scope& scope) const override;
+
+    Chunk chunk;
+};
+
+struct BytecodeCompiler {
+    void compile(std::shared_ptr<Scope> scope);
+
+  private:
+    std::shared_ptr<Bytecode> compile_scope(const Scope& scope);
+
+    void emit_statement(const std::shared_ptr<Statement>& statement, const Scope& scope);
+    void emit_scope(const Scope& scope);
+    void emit_expression(const Expression& expression, const Scope& scope, bool discard);
+    void emit_operand(const std::shared_ptr<Operand>& operand, const Scope& scope, bool discard);
+    void emit_fallback(const std::shared_ptr<Operand>& operand, const Scope& scope, bool discard);
+
+    int emit(OpCode op, int a = 0, int b = 0);
+    void patch(int index, int target);
+    int here() const {
+        return (int)chunk->code.size();
+    }
+
+    int add_constant(Object object);
+    int add_variable(const VariableRef& variable);
+    int add_function(const Function* function, const Scope& scope);
+
+    Chunk* chunk = nullptr;
+    int depth = 0;
+    std::vector<std::vector<int>> breaks;
+};
+
+}  // namespace llc
+
+#endif  // LLC_VM_H
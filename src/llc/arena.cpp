@@ -0,0 +1,86 @@
+#include <llc/arena.h>
+
+#include <new>
+
+namespace llc {
+
+namespace {
+
+// blocks are grouped by size in steps of 16 bytes, larger ones go straight to the heap. a free
+// list keeps at most "max_blocks" blocks so that a burst of frees does not stay resident
+constexpr size_t granularity = 16;
+constexpr size_t num_classes = 16;
+constexpr size_t max_blocks = 4096;
+
+struct Block {
+    Block* next;
+};
+
+// the free lists of a thread are plain data so that they stay usable while other thread locals
+// are destroyed, "reaper" empties them when the thread exits
+thread_local Block* free_lists[num_classes] = {};
+thread_local size_t free_counts[num_classes] = {};
+thread_local bool exited = false;
+
+struct Reaper {
+    ~Reaper() {
+        Arena::trim();
+        exited = true;
+    }
+};
+thread_local Reaper reaper;
+
+size_t size_class(size_t size) {
+    return (size + granularity - 1) / granularity - 1;
+}
+
+}  // namespace
+
+void* Arena::allocate(size_t size) {
+    Stats& counters = stats();
+    counters.allocations++;
+    counters.bytes += size;
+
+    size_t index = size_class(size);
+    if (index >= num_classes)
+        return ::operator new(size);
+    if (Block* block = free_lists[index]) {
+        free_lists[index] = block->next;
+        free_counts[index]--;
+        counters.reused++;
+        return block;
+    }
+    (void)&reaper;
+    return ::operator new((index + 1) * granularity);
+}
+
+void Arena::deallocate(void* ptr, size_t size) {
+    if (ptr == nullptr)
+        return;
+    size_t index = size_class(size);
+    if (index >= num_classes || exited || free_counts[index] >= max_blocks) {
+        ::operator delete(ptr);
+        return;
+    }
+    Block* block = static_cast<Block*>(ptr);
+    block->next = free_lists[index];
+    free_lists[index] = block;
+    free_counts[index]++;
+}
+
+void Arena::trim() {
+    for (size_t i = 0; i < num_classes; i++) {
+        while (Block* block = free_lists[i]) {
+            free_lists[i] = block->next;
+            ::operator delete(block);
+        }
+        free_counts[i] = 0;
+    }
+}
+
+Arena::Stats& Arena::stats() {
+    static thread_local Stats counters;
+    return counters;
+}
+
+}  // namespace llc
@@ -0,0 +1,428 @@
+#include <llc/closure.h>
+
+namespace llc {
+
+void ClosureCompiler::compile(std::shared_ptr<Scope> scope) {
+    std::vector<Scope*> definitions = collect_entry_scopes(scope.get());
+
+    std::vector<std::shared_ptr<ClosureBody>> compiled;
+    for (Scope* definition : definitions) {
+        auto body = std::make_shared<ClosureBody>();
+        loop_depth = 0;
+        body->action = compile_scope(*definition);
+        compiled.push_back(body);
+    }
+
+    for (size_t i = 0; i < definitions.size(); i++)
+        definitions[i]->compiled = compiled[i];
+}
+
+Completion ClosureBody::run(const Scope&) const {
+    std::optional<Object> result;
+    Flow flow = action(result);
+    return {flow, std::move(result)};
+}
+
+Action ClosureCompiler::compile_scope(const Scope& scope) {
+    std::vector<Action> actions;
+    for (const auto& statement : scope.statements)
+        actions.push_back(compile_statement(statement, scope));
+
+    if (actions.size() == 1)
+        return actions[0];
+
+    return [actions](std::optional<Object>& result) {
+        for (const auto& action : actions) {
+            Flow flow = action(result);
+            if (flow != Flow::Normal)
+                return flow;
+        }
+        return Flow::Normal;
+    };
+}
+
+Action ClosureCompiler::compile_statement(const std::shared_ptr<Statement>& statement,
+                                          const Scope& scope) {
+    LLC_CHECK(statement != nullptr);
+
+    if (auto expression = dynamic_cast<Expression*>(statement.get())) {
+        auto effect = compile_effect(*expression, scope);
+        return [effect](std::optional<Object>&) {
+            effect();
+            return Flow::Normal;
+        };
+
+    } else if (auto ret = dynamic_cast<Return*>(statement.get())) {
+        const Function* function =
+            ret->tail_call ? scope.find_function(ret->tail_call->function_name) : nullptr;
+        if (auto callee = tail_callee(function)) {
+            std::vector<Evaluator> arguments;
+            for (const auto& argument : ret->tail_call->arguments) {
+                LLC_CHECK(argument.operands.size() == 1);
+                arguments.push_back(compile_operand(argument.operands[0], scope).evaluate);
+            }
+            return [callee, arguments](std::optional<Object>&) {
+                Frame& frame = *Frame::current;
+                frame.tail_arguments.resize(arguments.size());
+                for (size_t i = 0; i < arguments.size(); i++)
+                    frame.tail_arguments[i] = arguments[i]();
+                frame.tail_function = callee;
+                return Flow::TailCall;
+            };
+        }
+        if (ret->expression.operands.empty())
+            return [](std::optional<Object>& result) {
+                result.reset();
+                return Flow::Return;
+            };
+        LLC_CHECK(ret->expression.operands.size() == 1);
+        auto value = compile_operand(ret->expression.operands[0], scope).evaluate;
+        return [value](std::optional<Object>& result) {
+            result.emplace();
+            *result = value();
+            return Flow::Return;
+        };
+
+    } else if (dynamic_cast<Break*>(statement.get()) && loop_depth != 0) {
+        return [](std::optional<Object>&) { return Flow::Break; };
+
+    } else if (auto chain = dynamic_cast<IfElseChain*>(statement.get())) {
+        std::vector<std::pair<Predicate, Action>> branches;
+        for (size_t i = 0; i < chain->conditions.size(); i++)
+            branches.push_back({compile_condition(chain->conditions[i], scope),
+                                compile_scope(*chain->bodys[i])});
+        Action otherwise;
+        if (chain->conditions.size() == chain->bodys.size() - 1)
+            otherwise = compile_scope(*chain->bodys.back());
+
+        if (branches.size() == 1) {
+            auto condition = branches[0].first;
+            auto body = branches[0].second;
+            if (otherwise)
+                return [condition, body, otherwise](std::optional<Object>& result) {
+                    return condition() ? body(result) : otherwise(result);
+                };
+            return [condition, body](std::optional<Object>& result) {
+                return condition() ? body(result) : Flow::Normal;
+            };
+        }
+        return [branches, otherwise](std::optional<Object>& result) {
+            for (const auto& branch : branches)
+                if (branch.first())
+                    return branch.second(result);
+            return otherwise ? otherwise(result) : Flow::Normal;
+        };
+
+    } else if (auto loop = dynamic_cast<For*>(statement.get())) {
+        const Scope& internal = *loop->internal_scope;
+        auto initialization = compile_effect(loop->initialization, internal);
+        Predicate condition = [] { return true; };
+        if (loop->condition.operands.size())
+            condition = compile_condition(loop->condition, internal);
+        auto updation = compile_effect(loop->updation, internal);
+        loop_depth++;
+        auto body = compile_scope(*loop->body);
+        loop_depth--;
+
+        // the counter of a counted loop is compared and stepped in place, see For::iterate()
+        if (loop->counted)
+            return [initialization, loop, body](std::optional<Object>& result) {
+                Flow exit = Flow::Normal;
+                initialization();
+                loop->iterate([&] {
+                    Flow flow = body(result);
+                    if (flow == Flow::Normal)
+                        return true;
+                    if (flow != Flow::Break)
+                        exit = flow;
+                    return false;
+                });
+                return exit;
+            };
+        return [initialization, condition, updation, body](std::optional<Object>& result) {
+            for (initialization(); condition(); updation()) {
+                Flow flow = body(result);
+                if (flow == Flow::Break)
+                    break;
+                if (flow != Flow::Normal)
+                    return flow;
+            }
+            return Flow::Normal;
+        };
+
+    } else if (auto loop = dynamic_cast<While*>(statement.get())) {
+        auto condition = compile_condition(loop->condition, scope);
+        loop_depth++;
+        auto body = compile_scope(*loop->body);
+        loop_depth--;
+
+        return [condition, body](std::optional<Object>& result) {
+            while (condition()) {
+                Flow flow = body(result);
+                if (flow == Flow::Break)
+                    break;
+                if (flow != Flow::Normal)
+                    return flow;
+            }
+            return Flow::Normal;
+        };
+
+    } else if (auto block = dynamic_cast<Scope*>(statement.get())) {
+        return compile_scope(*block);
+
+    } else {
+        const Scope* owner = &scope;
+        return [statement, owner](std::optional<Object>& result) {
+            Completion completion = statement->run(*owner);
+            if (completion.flow == Flow::Return)
+                result = std::move(completion.value);
+            return completion.flow;
+        };
+    }
+}
+
+std::function<void()> ClosureCompiler::compile_effect(const Expression& expression,
+                                                      const Scope& scope) {
+    if (expression.operands.empty())
+        return [] {};
+    LLC_CHECK(expression.operands.size() == 1);
+    return compile_effect(expression.operands[0], scope);
+}
+
+std::function<void()> ClosureCompiler::compile_effect(const std::shared_ptr<Operand>& operand,
+                                                      const Scope& scope) {
+    Operand* op = operand.get();
+
+    auto compound = [&](BinaryOp* binary, auto f) -> std::function<void()> {
+        VariableRef variable = resolve_variable(binary->a, scope);
+        if (!variable)
+            return [value = compile_fallback(operand, scope).evaluate] { value(); };
+        Value rhs = compile_operand(binary->b, scope);
+        if (rhs.place)
+            return [variable, place = rhs.place, constant = rhs.constant, f] {
+                f(variable.get(), place.get());
+            };
+        return [variable, value = rhs.evaluate, f] { f(variable.get(), value()); };
+    };
+
+    if (auto assignment = dynamic_cast<Assignment*>(op)) {
+        return compound(assignment, [](Object& lhs, const Object& rhs) { lhs.assign(rhs); });
+    } else if (auto add = dynamic_cast<AddEqual*>(op)) {
+        return compound(add, [](Object& lhs, const Object& rhs) { lhs += rhs; });
+    } else if (auto sub = dynamic_cast<SubtractEqual*>(op)) {
+        return compound(sub, [](Object& lhs, const Object& rhs) { lhs -= rhs; });
+    } else if (auto mul = dynamic_cast<MultiplyEqual*>(op)) {
+        return compound(mul, [](Object& lhs, const Object& rhs) { lhs *= rhs; });
+    } else if (auto div = dynamic_cast<DivideEqual*>(op)) {
+        return compound(div, [](Object& lhs, const Object& rhs) { lhs /= rhs; });
+
+    } else if (dynamic_cast<PreIncrement*>(op) || dynamic_cast<PostIncrement*>(op) ||
+               dynamic_cast<PreDecrement*>(op) || dynamic_cast<PostDecrement*>(op)) {
+        auto target = dynamic_cast<PreUnaryOp*>(op) ? dynamic_cast<PreUnaryOp*>(op)->operand
+                                                    : dynamic_cast<PostUnaryOp*>(op)->operand;
+        if (VariableRef variable = resolve_variable(target, scope)) {
+            if (dynamic_cast<PreIncrement*>(op) || dynamic_cast<PostIncrement*>(op))
+                return [variable] { ++variable.get(); };
+            else
+                return [variable] { --variable.get(); };
+        }
+    }
+
+    Value value = compile_operand(operand, scope);
+    if (value.place)
+        return [] {};
+    return [evaluate = value.evaluate] { evaluate(); };
+}
+
+Predicate ClosureCompiler::compile_condition(const Expression& expression, const Scope& scope) {
+    LLC_CHECK(expression.operands.size() == 1);
+    return compile_condition(expression.operands[0], scope);
+}
+
+Predicate ClosureCompiler::compile_condition(const std::shared_ptr<Operand>& operand,
+                                             const Scope& scope) {
+    Operand* op = operand.get();
+
+    auto comparison = [&](BinaryOp* binary, auto f) -> Predicate {
+        Value lhs = compile_operand(binary->a, scope);
+        Value rhs = compile_operand(binary->b, scope);
+
+        // the left side may only be read in place when evaluating the right side can not
+        // have side effects on it
+        if (lhs.place && rhs.place)
+            return [a = lhs.place, b = rhs.place, ca = lhs.constant, cb = rhs.constant, f] {
+                return f(a.get(), b.get());
+            };
+        if (rhs.place)
+            return [a = lhs.evaluate, b = rhs.place, cb = rhs.constant, f] {
+                return f(a(), b.get());
+            };
+        return [a = lhs.evaluate, b = rhs.evaluate, f] {
+            Object lhs = a();
+            return f(lhs, b());
+        };
+    };
+
+    if (auto lt = dynamic_cast<LessThan*>(op))
+        return comparison(lt, [](const Object& a, const Object& b) { return a < b; });
+    else if (auto le = dynamic_cast<LessEqual*>(op))
+        return comparison(le, [](const Object& a, const Object& b) { return a <= b; });
+    else if (auto gt = dynamic_cast<GreaterThan*>(op))
+        return comparison(gt, [](const Object& a, const Object& b) { return a > b; });
+    else if (auto ge = dynamic_cast<GreaterEqual*>(op))
+        return comparison(ge, [](const Object& a, const Object& b) { return a >= b; });
+    else if (auto eq = dynamic_cast<Equal*>(op))
+        return comparison(eq, [](const Object& a, const Object& b) { return a == b; });
+    else if (auto ne = dynamic_cast<NotEqual*>(op))
+        return comparison(ne, [](const Object& a, const Object& b) { return a != b; });
+
+    Value value = compile_operand(operand, scope);
+    if (value.place)
+        return [place = value.place, constant = value.constant] {
+            return place.get().as<bool>();
+        };
+    return [evaluate = value.evaluate] { return evaluate().as<bool>(); };
+}
+
+ClosureCompiler::Value ClosureCompiler::compile_operand(const std::shared_ptr<Operand>& operand,
+                                                        const Scope& scope) {
+    Operand* op = operand.get();
+
+    auto constant = [](Object object) -> Value {
+        auto constant = std::make_shared<Object>(object);
+        VariableRef place;
+        place.object = constant.get();
+        return {[constant] { return *constant; }, place, constant};
+    };
+
+    auto arithmetic = [&](BinaryOp* binary, auto f) -> Value {
+        Evaluator lhs = compile_operand(binary->a, scope).evaluate;
+        Value rhs = compile_operand(binary->b, scope);
+        if (rhs.place)
+            return {[lhs, b = rhs.place, cb = rhs.constant, f] {
+                Object result = lhs();
+                f(result, b.get());
+                return result;
+            }};
+        return {[lhs, b = rhs.evaluate, f] {
+            Object result = lhs();
+            f(result, b());
+            return result;
+        }};
+    };
+
+    auto compound = [&](BinaryOp* binary) -> Value {
+        VariableRef variable = resolve_variable(binary->a, scope);
+        if (!variable)
+            return compile_fallback(operand, scope);
+        auto effect = compile_effect(operand, scope);
+        return {[variable, effect] {
+            effect();
+            return variable.get();
+        }};
+    };
+
+    if (auto literal = dynamic_cast<NumberLiteral*>(op)) {
+        return constant(literal->value);
+    } else if (auto literal = dynamic_cast<CharLiteral*>(op)) {
+        return constant(Object(literal->value));
+    } else if (auto literal = dynamic_cast<StringLiteral*>(op)) {
+        return constant(Object(literal->value));
+
+    } else if (dynamic_cast<VariableOp*>(op)) {
+        VariableRef variable = resolve_variable(operand, scope);
+        if (!variable)
+            return compile_fallback(operand, scope);
+        return {[variable] { return variable.get(); }, variable};
+
+    } else if (auto add = dynamic_cast<Addition*>(op)) {
+        return arithmetic(add, [](Object& a, const Object& b) { a += b; });
+    } else if (auto sub = dynamic_cast<Subtrbody*>(op)) {
+        return arithmetic(sub, [](Object& a, const Object& b) { a -= b; });
+    } else if (auto mul = dynamic_cast<Multiplication*>(op)) {
+        return arithmetic(mul, [](Object& a, const Object& b) { a *= b; });
+    } else if (auto div = dynamic_cast<Division*>(op)) {
+        return arithmetic(div, [](Object& a, const Object& b) { a /= b; });
+
+    } else if (dynamic_cast<LessThan*>(op) || dynamic_cast<LessEqual*>(op) ||
+               dynamic_cast<GreaterThan*>(op) || dynamic_cast<GreaterEqual*>(op) ||
+               dynamic_cast<Equal*>(op) || dynamic_cast<NotEqual*>(op)) {
+        return {[condition = compile_condition(operand, scope)] { return Object(condition()); }};
+
+    } else if (auto assignment = dynamic_cast<Assignment*>(op)) {
+        return compound(assignment);
+    } else if (auto add = dynamic_cast<AddEqual*>(op)) {
+        return compound(add);
+    } else if (auto sub = dynamic_cast<SubtractEqual*>(op)) {
+        return compound(sub);
+    } else if (auto mul = dynamic_cast<MultiplyEqual*>(op)) {
+        return compound(mul);
+    } else if (auto div = dynamic_cast<DivideEqual*>(op)) {
+        return compound(div);
+
+    } else if (auto negation = dynamic_cast<Negation*>(op)) {
+        return {[value = compile_operand(negation->operand, scope).evaluate] {
+            return -value();
+        }};
+
+    } else if (dynamic_cast<PreIncrement*>(op) || dynamic_cast<PreDecrement*>(op)) {
+        VariableRef variable = resolve_variable(dynamic_cast<PreUnaryOp*>(op)->operand, scope);
+        if (!variable)
+            return compile_fallback(operand, scope);
+        if (dynamic_cast<PreIncrement*>(op))
+            return {[variable] { return ++variable.get(); }};
+        return {[variable] { return --variable.get(); }};
+
+    } else if (dynamic_cast<PostIncrement*>(op) || dynamic_cast<PostDecrement*>(op)) {
+        VariableRef variable = resolve_variable(dynamic_cast<PostUnaryOp*>(op)->operand, scope);
+        if (!variable)
+            return compile_fallback(operand, scope);
+        if (dynamic_cast<PostIncrement*>(op))
+            return {[variable] { return variable.get()++; }};
+        return {[variable] { return variable.get()--; }};
+
+    } else if (auto call = dynamic_cast<FunctionCallOp*>(op)) {
+        if (scope.find_function(call->function.function_name) == nullptr)
+            return compile_fallback(operand, scope);
+        return compile_call(call->function, scope);
+    }
+
+    return compile_fallback(operand, scope);
+}
+
+ClosureCompiler::Value ClosureCompiler::compile_fallback(const std::shared_ptr<Operand>& operand,
+                                                         const Scope& scope) {
+    const Scope* owner = &scope;
+    return {[operand, owner] { return operand->evaluate(*owner); }};
+}
+
+ClosureCompiler::Value ClosureCompiler::compile_call(const FunctionCall& call,
+                                                     const Scope& scope) {
+    const Function* function = scope.find_function(call.function_name);
+    LLC_CHECK(function != nullptr);
+
+    std::vector<Evaluator> arguments;
+    for (const auto& argument : call.arguments) {
+        LLC_CHECK(argument.operands.size() == 1);
+        arguments.push_back(compile_operand(argument.operands[0], scope).evaluate);
+    }
+
+    const Scope* owner = &scope;
+    return {[function, owner, arguments] {
+        ScratchVector<Object> args;
+        for (const auto& argument : arguments)
+            args.values.push_back(argument());
+
+        if (auto result = function->call(*owner, args.values))
+            return std::move(*result);
+        return Object();
+    }};
+}
+
+VariableRef ClosureCompiler::resolve_variable(const std::shared_ptr<Operand>& operand,
+                                              const Scope&) {
+    auto variable = dynamic_cast<VariableOp*>(operand.get());
+    return variable ? variable->ref : VariableRef();
+}
+
+}  // namespace llc
@@ -0,0 +1,88 @@
+#include <llc/heap.h>
+
+namespace llc {
+
+namespace {
+
+// values larger than a quarter of a chunk, or aligned more strictly than the chunks are, get a
+// block of their own
+constexpr size_t chunk_size = 64 * 1024;
+constexpr size_t max_chunked = chunk_size / 4;
+
+thread_local Heap* current_heap = nullptr;
+
+}  // namespace
+
+Heap::~Heap() {
+    release();
+    for (char* block : chunks)
+        ::operator delete(block);
+}
+
+void* Heap::allocate(size_t size, size_t alignment) {
+    std::lock_guard<std::mutex> lock(mutex);
+    counters.live_bytes += size;
+    counters.allocations++;
+
+    if (size > max_chunked || alignment > alignof(std::max_align_t)) {
+        void* block = ::operator new(size, std::align_val_t(alignment));
+        large.push_back({block, alignment});
+        counters.reserved_bytes += size;
+        return block;
+    }
+
+    offset = (offset + alignment - 1) / alignment * alignment;
+    if (chunks.empty() || offset + size > chunk_size) {
+        if (!chunks.empty())
+            chunk++;
+        if (chunk == chunks.size()) {
+            chunks.push_back(static_cast<char*>(::operator new(chunk_size)));
+            counters.reserved_bytes += chunk_size;
+        }
+        offset = 0;
+    }
+    void* ptr = chunks[chunk] + offset;
+    offset += size;
+    return ptr;
+}
+
+void Heap::finalize(void* object, void (*destroy)(void*)) {
+    std::lock_guard<std::mutex> lock(mutex);
+    finalizers.push_back({destroy, object});
+}
+
+void Heap::release() {
+    std::lock_guard<std::mutex> lock(mutex);
+    for (auto it = finalizers.rbegin(); it != finalizers.rend(); ++it)
+        it->destroy(it->object);
+    finalizers.clear();
+
+    for (const auto& [block, alignment] : large)
+        ::operator delete(block, std::align_val_t(alignment));
+    large.clear();
+    counters.reserved_bytes = chunks.size() * chunk_size;
+
+    chunk = 0;
+    offset = 0;
+    counters.live_bytes = 0;
+    counters.allocations = 0;
+}
+
+Heap::Stats Heap::stats() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    return counters;
+}
+
+Heap& Heap::current() {
+    static Heap shared;
+    return current_heap ? *current_heap : shared;
+}
+
+Heap::Use::Use(Heap& heap) : previous(current_heap) {
+    current_heap = &heap;
+}
+Heap::Use::~Use() {
+    current_heap = previous;
+}
+
+}  // namespace llc
@@ -0,0 +1,1262 @@
+#include <llc/ir.h>
+
+#include <algorithm>
+#include <cstring>
+#include <functional>
+#include <map>
+#include <set>
+#include <sstream>
+#include <tuple>
+
+namespace llc {
+
+namespace ir {
+
+namespace {
+
+// thrown while lowering a construct the IR does not represent, the function is then not lowered
+struct Unsupported {};
+
+bool is_arithmetic(size_t type) {
+    return type == typeid_bool || type == typeid_char || type == typeid_int ||
+           type == typeid_int64 || type == typeid_float || type == typeid_double;
+}
+
+bool is_integral(size_t type) {
+    return type == typeid_bool || type == typeid_char || type == typeid_int || type == typeid_int64;
+}
+
+// the value a local of type "type" starts from
+Object zero(size_t type) {
+    if (type == typeid_bool)
+        return Object(false);
+    if (type == typeid_char)
+        return Object((char)0);
+    if (type == typeid_int)
+        return Object(0);
+    if (type == typeid_int64)
+        return Object((int64_t)0);
+    if (type == typeid_float)
+        return Object(0.0f);
+    LLC_CHECK(type == typeid_double);
+    return Object(0.0);
+}
+
+uint64_t bits_of(const Object& object) {
+    return object.visit([](auto value) {
+        uint64_t bits = 0;
+        memcpy(&bits, &value, sizeof(value));
+        return bits;
+    });
+}
+
+bool same_constant(const Object& lhs, const Object& rhs) {
+    return lhs.type_id() == rhs.type_id() && bits_of(lhs) == bits_of(rhs);
+}
+
+// the only value a phi merges other than itself, or -1 when it merges several
+int trivial_phi(const Function& function, int phi) {
+    int same = -1;
+    for (int operand : function.values[phi].operands) {
+        if (operand == phi || operand == same)
+            continue;
+        if (same != -1)
+            return -1;
+        same = operand;
+    }
+    return same;
+}
+
+// lowers an internal function to SSA form while walking its statements once, following "Simple
+// and Efficient Construction of Static Single Assignment Form" (Braun et al.): the value of a
+// variable in a block is looked up in its predecessors, through a phi when there are several. a
+// block is sealed once all its predecessors are known, reads in a block not yet sealed, such as a
+// loop header, get a phi whose operands are filled in when it is
+struct Builder {
+    Builder(const std::string& name, const InternalFunction& source) : source(source) {
+        function.name = name;
+    }
+
+    Function build() {
+        const Scope& definition = *source.definition;
+        if (!definition.members.empty())
+            throw Unsupported();
+        function.scope = &definition;
+        function.return_type = source.return_type_id();
+        if (function.return_type != typeid_unknown && !is_arithmetic(function.return_type))
+            throw Unsupported();
+
+        current = new_block();
+        seal(current);
+
+        // parameters are the first locals, the others start from their declared value. a local
+        // declared without a type, such as a temporary of the optimizer, takes the type of the
+        // first value assigned to it
+        int parameters = (int)source.parameters.size();
+        if ((int)definition.frame.size() < parameters)
+            throw Unsupported();
+        for (int i = 0; i < (int)definition.frame.size(); i++) {
+            const Object& prototype = definition.frame[i];
+            typed.push_back(!prototype.is_void());
+            types.push_back(typed.back() && is_arithmetic(prototype.type_id())
+                                ? prototype.type_id()
+                                : typeid_unknown);
+            if (i < parameters) {
+                if (types[i] == typeid_unknown)
+                    throw Unsupported();
+                function.parameters.push_back(types[i]);
+                Instruction parameter;
+                parameter.op = Op::Parameter;
+                parameter.type = types[i];
+                parameter.index = i;
+                definitions[current][i] = emit(std::move(parameter));
+            } else if (types[i] != typeid_unknown) {
+                definitions[current][i] = constant(prototype);
+            }
+        }
+
+        emit_scope(definition);
+        if (current >= 0)
+            leave(-1);
+        return std::move(function);
+    }
+
+  private:
+    int new_block() {
+        function.blocks.emplace_back();
+        definitions.emplace_back();
+        incomplete.emplace_back();
+        sealed.push_back(false);
+        return (int)function.blocks.size() - 1;
+    }
+
+    void seal(int block) {
+        auto phis = incomplete[block];
+        for (const auto& [variable, phi] : phis)
+            add_phi_operands(variable, phi);
+        sealed[block] = true;
+    }
+
+    // ends the current block with a jump, a branch or a return
+    void jump_from(int block, int target) {
+        function.blocks[block].exit = Exit::Jump;
+        function.blocks[block].targets[0] = target;
+        function.blocks[target].predecessors.push_back(block);
+    }
+    void jump(int target) {
+        jump_from(current, target);
+        current = -1;
+    }
+    void branch(int condition, int taken, int not_taken) {
+        Block& block = function.blocks[current];
+        block.exit = Exit::Branch;
+        block.condition = condition;
+        block.targets[0] = taken;
+        block.targets[1] = not_taken;
+        function.blocks[taken].predecessors.push_back(current);
+        function.blocks[not_taken].predecessors.push_back(current);
+        current = -1;
+    }
+    void leave(int value) {
+        function.blocks[current].exit = Exit::Return;
+        function.blocks[current].value = value;
+        current = -1;
+    }
+
+    int emit(Instruction instruction) {
+        instruction.block = current;
+        function.values.push_back(std::move(instruction));
+        int id = (int)function.values.size() - 1;
+        function.blocks[current].instructions.push_back(id);
+        return id;
+    }
+    int emit(Op op, size_t type, std::vector<int> operands) {
+        Instruction instruction;
+        instruction.op = op;
+        instruction.type = type;
+        instruction.operands = std::move(operands);
+        return emit(std::move(instruction));
+    }
+    int constant(const Object& value) {
+        if (value.is_void() || !is_arithmetic(value.type_id()))
+            throw Unsupported();
+        Instruction instruction;
+        instruction.op = Op::Constant;
+        instruction.type = value.type_id();
+        instruction.constant = value;
+        return emit(std::move(instruction));
+    }
+    int convert(int value, size_t type) {
+        if (function.values[value].type == type)
+            return value;
+        return emit(Op::Convert, type, {value});
+    }
+    size_t type_of(int value) const {
+        return function.values[value].type;
+    }
+
+    int phi(int block, int variable) {
+        if (types[variable] == typeid_unknown)
+            throw Unsupported();
+        Instruction instruction;
+        instruction.op = Op::Phi;
+        instruction.type = types[variable];
+        instruction.block = block;
+        function.values.push_back(std::move(instruction));
+        int id = (int)function.values.size() - 1;
+
+        auto& instructions = function.blocks[block].instructions;
+        auto position = std::find_if(instructions.begin(), instructions.end(),
+                                     [&](int value) { return !function.is_phi(value); });
+        instructions.insert(position, id);
+        return id;
+    }
+
+    int read(int variable, int block) {
+        auto found = definitions[block].find(variable);
+        if (found != definitions[block].end())
+            return found->second;
+
+        const auto& predecessors = function.blocks[block].predecessors;
+        int value;
+        if (!sealed[block]) {
+            value = phi(block, variable);
+            incomplete[block][variable] = value;
+        } else if (predecessors.size() == 1) {
+            value = read(variable, predecessors[0]);
+        } else if (predecessors.empty()) {
+            // read before anything was assigned to a local declared without a type
+            throw Unsupported();
+        } else {
+            value = phi(block, variable);
+            definitions[block][variable] = value;
+            add_phi_operands(variable, value);
+        }
+        definitions[block][variable] = value;
+        return value;
+    }
+    void add_phi_operands(int variable, int phi) {
+        int block = function.values[phi].block;
+        for (size_t i = 0; i < function.blocks[block].predecessors.size(); i++) {
+            int value = read(variable, function.blocks[block].predecessors[i]);
+            function.values[phi].operands.push_back(value);
+        }
+    }
+
+    int local_of(const std::shared_ptr<Operand>& operand) const {
+        auto variable = dynamic_cast<VariableOp*>(operand.get());
+        // a variable found outside of the frame is a global or a member and not represented
+        if (variable == nullptr || variable->ref.local < 0 ||
+            variable->ref.local >= (int)types.size())
+            throw Unsupported();
+        return variable->ref.local;
+    }
+    int read_local(int variable) {
+        if (types[variable] == typeid_unknown)
+            throw Unsupported();
+        return read(variable, current);
+    }
+    // "value" is converted to the type of the local
+    int write_local(int variable, int value) {
+        if (types[variable] == typeid_unknown) {
+            if (typed[variable] || !is_arithmetic(type_of(value)))
+                throw Unsupported();
+            types[variable] = type_of(value);
+        }
+        value = convert(value, types[variable]);
+        definitions[current][variable] = value;
+        return value;
+    }
+
+    void emit_scope(const Scope& scope) {
+        for (const auto& statement : scope.statements) {
+            // what follows a return or a break is never run
+            if (current < 0)
+                break;
+            emit_statement(statement.get(), scope);
+        }
+    }
+
+    void emit_statement(Statement* statement, const Scope& scope) {
+        if (auto expression = dynamic_cast<Expression*>(statement)) {
+            emit_effect(*expression, scope);
+
+        } else if (auto call = dynamic_cast<FunctionCall*>(statement)) {
+            emit_call(*call, scope);
+
+        } else if (auto ret = dynamic_cast<Return*>(statement)) {
+            int value = -1;
+            if (ret->expression.operands.size()) {
+                if (function.return_type == typeid_unknown)
+                    throw Unsupported();
+                value = convert(emit_value(ret->expression, scope), function.return_type);
+            }
+            leave(value);
+
+        } else if (dynamic_cast<Break*>(statement)) {
+            // a break outside of any loop ends the function like a return without value
+            if (breaks.empty()) {
+                leave(-1);
+            } else {
+                breaks.back().push_back(current);
+                current = -1;
+            }
+
+        } else if (auto chain = dynamic_cast<IfElseChain*>(statement)) {
+            std::vector<int> ends;
+            for (size_t i = 0; i < chain->conditions.size(); i++) {
+                int condition = emit_condition(chain->conditions[i], scope);
+                int taken = new_block(), not_taken = new_block();
+                branch(condition, taken, not_taken);
+                seal(taken);
+                seal(not_taken);
+                current = taken;
+                emit_scope(*chain->bodys[i]);
+                if (current >= 0)
+                    ends.push_back(current);
+                current = not_taken;
+            }
+            if (chain->bodys.size() == chain->conditions.size() + 1)
+                emit_scope(*chain->bodys.back());
+            if (current >= 0)
+                ends.push_back(current);
+            join(ends);
+
+        } else if (auto loop = dynamic_cast<For*>(statement)) {
+            const Scope& internal = *loop->internal_scope;
+            emit_effect(loop->initialization, internal);
+            int header = new_block();
+            jump_from(current, header);
+            current = header;
+
+            int body = new_block();
+            std::vector<int> exits;
+            if (loop->condition.operands.size()) {
+                int condition = emit_condition(loop->condition, internal);
+                int exit = new_block();
+                branch(condition, body, exit);
+                seal(exit);
+                exits.push_back(exit);
+            } else {
+                jump(body);
+            }
+            seal(body);
+
+            current = body;
+            breaks.emplace_back();
+            emit_scope(*loop->body);
+            if (current >= 0) {
+                emit_effect(loop->updation, internal);
+                jump(header);
+            }
+            seal(header);
+            for (int block : breaks.back())
+                exits.push_back(block);
+            breaks.pop_back();
+            join(exits);
+
+        } else if (auto loop = dynamic_cast<While*>(statement)) {
+            int header = new_block();
+            jump_from(current, header);
+            current = header;
+
+            int condition = emit_condition(loop->condition, scope);
+            int body = new_block(), exit = new_block();
+            branch(condition, body, exit);
+            seal(body);
+            seal(exit);
+
+            current = body;
+            breaks.emplace_back();
+            emit_scope(*loop->body);
+            if (current >= 0)
+                jump(header);
+            seal(header);
+            std::vector<int> exits = {exit};
+            for (int block : breaks.back())
+                exits.push_back(block);
+            breaks.pop_back();
+            join(exits);
+
+        } else if (auto block = dynamic_cast<Scope*>(statement)) {
+            emit_scope(*block);
+
+        } else {
+            throw Unsupported();
+        }
+    }
+
+    // continues in a new block reached from each of "ends", the blocks left open where a
+    // statement finishes. the code that follows is never run when there are none
+    void join(const std::vector<int>& ends) {
+        if (ends.empty()) {
+            current = -1;
+            return;
+        }
+        int target = new_block();
+        for (int block : ends)
+            jump_from(block, target);
+        seal(target);
+        current = target;
+    }
+
+    void emit_effect(const Expression& expression, const Scope& scope) {
+        if (expression.operands.size() > 1)
+            throw Unsupported();
+        if (expression.operands.size())
+            emit_operand(expression.operands[0], scope);
+    }
+
+    int emit_value(const Expression& expression, const Scope& scope) {
+        if (expression.operands.size() != 1)
+            throw Unsupported();
+        int value = emit_operand(expression.operands[0], scope);
+        if (value < 0)
+            throw Unsupported();
+        return value;
+    }
+
+    int emit_condition(const Expression& expression, const Scope& scope) {
+        return convert(emit_value(expression, scope), typeid_bool);
+    }
+
+    // returns -1 for calls without result
+    int emit_call(const FunctionCall& call, const Scope& scope) {
+        const llc::Function* callee = scope.find_function(call.function_name);
+        if (callee == nullptr || callee->base == nullptr)
+            throw Unsupported();
+        size_t type = callee->base->return_type_id();
+        if (type != typeid_unknown && !is_arithmetic(type))
+            throw Unsupported();
+
+        Instruction instruction;
+        instruction.op = Op::Call;
+        instruction.type = type;
+        instruction.function = callee;
+        instruction.name = call.function_name;
+        for (const auto& argument : call.arguments)
+            instruction.operands.push_back(emit_value(argument, scope));
+        int id = emit(std::move(instruction));
+        return type == typeid_unknown ? -1 : id;
+    }
+
+    int emit_operand(const std::shared_ptr<Operand>& operand, const Scope& scope) {
+        Operand* op = operand.get();
+
+        if (auto literal = dynamic_cast<NumberLiteral*>(op))
+            return constant(literal->value);
+        if (auto literal = dynamic_cast<CharLiteral*>(op))
+            return constant(Object(literal->value));
+        if (dynamic_cast<VariableOp*>(op))
+            return read_local(local_of(operand));
+        if (auto call = dynamic_cast<FunctionCallOp*>(op))
+            return emit_call(call->function, scope);
+
+        if (auto type = dynamic_cast<TypeOp*>(op)) {
+            if (type->type.is_void() || !is_arithmetic(type->type.type_id()) ||
+                type->arguments.size() > 1)
+                throw Unsupported();
+            if (type->arguments.empty())
+                return constant(type->type);
+            return convert(emit_value(type->arguments[0], scope), type->type.type_id());
+        }
+
+        if (auto assignment = dynamic_cast<Assignment*>(op)) {
+            int variable = local_of(assignment->a);
+            int value = emit_operand(assignment->b, scope);
+            if (value < 0)
+                throw Unsupported();
+            // the assigned value is copied so that the listing shows the assignment
+            if (types[variable] == typeid_unknown || types[variable] == type_of(value))
+                value = emit(Op::Copy, type_of(value), {value});
+            return write_local(variable, value);
+        }
+
+        if (auto binary = dynamic_cast<BinaryOp*>(op)) {
+            std::optional<Op> compound;
+            if (dynamic_cast<AddEqual*>(op))
+                compound = Op::Add;
+            else if (dynamic_cast<SubtractEqual*>(op))
+                compound = Op::Sub;
+            else if (dynamic_cast<MultiplyEqual*>(op))
+                compound = Op::Mul;
+            else if (dynamic_cast<DivideEqual*>(op))
+                compound = Op::Div;
+            if (compound) {
+                int variable = local_of(binary->a);
+                int lhs = read_local(variable);
+                if (type_of(lhs) == typeid_bool)
+                    throw Unsupported();
+                int rhs = convert(required(emit_operand(binary->b, scope)), type_of(lhs));
+                return write_local(variable, emit(*compound, type_of(lhs), {lhs, rhs}));
+            }
+
+            std::optional<Op> arithmetic, comparison;
+            if (dynamic_cast<Addition*>(op))
+                arithmetic = Op::Add;
+            else if (dynamic_cast<Subtrbody*>(op))
+                arithmetic = Op::Sub;
+            else if (dynamic_cast<Multiplication*>(op))
+                arithmetic = Op::Mul;
+            else if (dynamic_cast<Division*>(op))
+                arithmetic = Op::Div;
+            else if (dynamic_cast<LessThan*>(op))
+                comparison = Op::LessThan;
+            else if (dynamic_cast<LessEqual*>(op))
+                comparison = Op::LessEqual;
+            else if (dynamic_cast<GreaterThan*>(op))
+                comparison = Op::GreaterThan;
+            else if (dynamic_cast<GreaterEqual*>(op))
+                comparison = Op::GreaterEqual;
+            else if (dynamic_cast<Equal*>(op))
+                comparison = Op::Equal;
+            else if (dynamic_cast<NotEqual*>(op))
+                comparison = Op::NotEqual;
+            else
+                throw Unsupported();
+
+            // the right hand side is converted to the type of the left hand side, as the
+            // operators of Object do
+            int lhs = required(emit_operand(binary->a, scope));
+            int rhs = convert(required(emit_operand(binary->b, scope)), type_of(lhs));
+            if (comparison)
+                return emit(*comparison, typeid_bool, {lhs, rhs});
+            if (type_of(lhs) == typeid_bool)
+                throw Unsupported();
+            return emit(*arithmetic, type_of(lhs), {lhs, rhs});
+        }
+
+        bool increment = dynamic_cast<PreIncrement*>(op) || dynamic_cast<PostIncrement*>(op);
+        bool decrement = dynamic_cast<PreDecrement*>(op) || dynamic_cast<PostDecrement*>(op);
+        if (increment || decrement) {
+            bool post = dynamic_cast<PostUnaryOp*>(op) != nullptr;
+            int variable = local_of(post ? dynamic_cast<PostUnaryOp*>(op)->operand
+                                         : dynamic_cast<PreUnaryOp*>(op)->operand);
+            int old = read_local(variable);
+            size_t type = type_of(old);
+            if (type == typeid_bool)
+                throw Unsupported();
+            Object one = zero(type);
+            one.assign(Object(1));
+            int value = emit(increment ? Op::Add : Op::Sub, type, {old, constant(one)});
+            write_local(variable, value);
+            return post ? old : value;
+        }
+
+        if (auto negation = dynamic_cast<Negation*>(op)) {
+            int value = required(emit_operand(negation->operand, scope));
+            if (type_of(value) == typeid_bool)
+                throw Unsupported();
+            return emit(Op::Neg, type_of(value), {value});
+        }
+
+        throw Unsupported();
+    }
+
+    static int required(int value) {
+        if (value < 0)
+            throw Unsupported();
+        return value;
+    }
+
+    const InternalFunction& source;
+    Function function;
+    int current = -1;
+
+    std::vector<size_t> types;
+    std::vector<bool> typed;
+    // the value of each local at the end of each block, as far as it is assigned there
+    std::vector<std::map<int, int>> definitions;
+    // the phis of blocks not yet sealed, by local
+    std::vector<std::map<int, int>> incomplete;
+    std::vector<bool> sealed;
+    std::vector<std::vector<int>> breaks;
+};
+
+void collect_functions(Scope* scope, std::set<Scope*>& visited, std::vector<Function>& functions) {
+    if (!visited.insert(scope).second)
+        return;
+    for_each_block(scope, [&](Scope* block) {
+        for (auto& function : block->functions) {
+            auto internal = dynamic_cast<InternalFunction*>(function.second.base.get());
+            if (internal == nullptr || internal->definition == nullptr)
+                continue;
+            collect_functions(internal->definition.get(), visited, functions);
+            if (auto lowered = build(function.first, *internal))
+                functions.push_back(std::move(*lowered));
+        }
+    });
+}
+
+const char* name_of(Op op) {
+    switch (op) {
+    case Op::Constant: return "const";
+    case Op::Parameter: return "parameter";
+    case Op::Copy: return "copy";
+    case Op::Phi: return "phi";
+    case Op::Convert: return "convert";
+    case Op::Add: return "add";
+    case Op::Sub: return "sub";
+    case Op::Mul: return "mul";
+    case Op::Div: return "div";
+    case Op::Neg: return "neg";
+    case Op::LessThan: return "lt";
+    case Op::LessEqual: return "le";
+    case Op::GreaterThan: return "gt";
+    case Op::GreaterEqual: return "ge";
+    case Op::Equal: return "eq";
+    case Op::NotEqual: return "ne";
+    case Op::Call: return "call";
+    }
+    return "";
+}
+
+}  // namespace
+
+std::vector<int> Block::successors() const {
+    if (removed || exit == Exit::Return)
+        return {};
+    if (exit == Exit::Jump)
+        return {targets[0]};
+    return {targets[0], targets[1]};
+}
+
+void Function::replace(int value, int by) {
+    for (auto& block : blocks) {
+        if (block.removed)
+            continue;
+        for (int id : block.instructions)
+            for (int& operand : values[id].operands)
+                if (operand == value)
+                    operand = by;
+        if (block.condition == value)
+            block.condition = by;
+        if (block.value == value)
+            block.value = by;
+    }
+    remove(value);
+}
+
+void Function::remove(int value) {
+    Instruction& instruction = values[value];
+    if (instruction.block < 0)
+        return;
+    auto& instructions = blocks[instruction.block].instructions;
+    instructions.erase(std::find(instructions.begin(), instructions.end(), value));
+    instruction.block = -1;
+}
+
+void Function::remove_edge(int from, int to) {
+    Block& block = blocks[to];
+    auto found = std::find(block.predecessors.begin(), block.predecessors.end(), from);
+    if (found == block.predecessors.end())
+        return;
+    size_t index = found - block.predecessors.begin();
+    block.predecessors.erase(found);
+    for (int id : block.instructions)
+        if (is_phi(id))
+            values[id].operands.erase(values[id].operands.begin() + index);
+}
+
+void Function::remove_block(int index) {
+    for (int successor : blocks[index].successors())
+        remove_edge(index, successor);
+    Block& block = blocks[index];
+    for (int id : block.instructions)
+        values[id].block = -1;
+    block.instructions.clear();
+    block.predecessors.clear();
+    block.removed = true;
+}
+
+std::optional<Function> build(const std::string& name, const InternalFunction& function) {
+    if (function.definition == nullptr)
+        return std::nullopt;
+    try {
+        return Builder(name, function).build();
+    } catch (const Unsupported&) {
+        return std::nullopt;
+    }
+}
+
+std::vector<Function> build(Scope* scope) {
+    std::vector<Function> functions;
+    std::set<Scope*> visited;
+    collect_functions(scope, visited, functions);
+    std::sort(functions.begin(), functions.end(),
+              [](const Function& lhs, const Function& rhs) { return lhs.name < rhs.name; });
+    return functions;
+}
+
+std::string print(const Function& function) {
+    std::ostringstream out;
+    auto value = [&](int id) { out << '%' << id; };
+
+    out << "function " << function.name << '(';
+    for (size_t i = 0; i < function.parameters.size(); i++)
+        out << (i ? ", " : "") << get_type_name(function.parameters[i]);
+    out << ')';
+    if (function.return_type != typeid_unknown)
+        out << " -> " << get_type_name(function.return_type);
+    out << '\n';
+
+    for (size_t b = 0; b < function.blocks.size(); b++) {
+        const Block& block = function.blocks[b];
+        if (block.removed)
+            continue;
+        out << 'b' << b << ':';
+        for (size_t i = 0; i < block.predecessors.size(); i++)
+            out << (i ? ", b" : "  ; from b") << block.predecessors[i];
+        out << '\n';
+
+        for (int id : block.instructions) {
+            const Instruction& instruction = function.values[id];
+            out << "    ";
+            if (instruction.type != typeid_unknown) {
+                value(id);
+                out << " = ";
+            }
+            out << name_of(instruction.op);
+            if (instruction.type != typeid_unknown)
+                out << ' ' << get_type_name(instruction.type);
+
+            if (instruction.op == Op::Constant) {
+                instruction.constant.visit([&](auto constant) {
+                    using T = decltype(constant);
+                    if constexpr (std::is_same_v<T, bool>)
+                        out << (constant ? " true" : " false");
+                    else if constexpr (std::is_same_v<T, char>)
+                        out << ' ' << (int)constant;
+                    else
+                        out << ' ' << constant;
+                });
+            } else if (instruction.op == Op::Parameter) {
+                out << ' ' << instruction.index;
+            } else if (instruction.op == Op::Phi) {
+                for (size_t i = 0; i < instruction.operands.size(); i++) {
+                    out << (i ? ", [" : " [");
+                    value(instruction.operands[i]);
+                    out << ", b" << block.predecessors[i] << ']';
+                }
+            } else {
+                if (instruction.op == Op::Call)
+                    out << ' ' << instruction.name << '(';
+                for (size_t i = 0; i < instruction.operands.size(); i++) {
+                    out << (i ? ", " : instruction.op == Op::Call ? "" : " ");
+                    value(instruction.operands[i]);
+                }
+                if (instruction.op == Op::Call)
+                    out << ')';
+            }
+            out << '\n';
+        }
+
+        switch (block.exit) {
+        case Exit::Jump: out << "    jump b" << block.targets[0] << '\n'; break;
+        case Exit::Branch:
+            out << "    branch ";
+            value(block.condition);
+            out << ", b" << block.targets[0] << ", b" << block.targets[1] << '\n';
+            break;
+        case Exit::Return:
+            out << "    return";
+            if (block.value >= 0) {
+                out << ' ';
+                value(block.value);
+            }
+            out << '\n';
+            break;
+        }
+    }
+    return out.str();
+}
+
+std::optional<Object> evaluate(const Instruction& instruction,
+                               const std::vector<Object>& operands) {
+    switch (instruction.op) {
+    case Op::Constant: return instruction.constant;
+    case Op::Copy: return operands[0];
+    case Op::Convert: {
+        Object result = zero(instruction.type);
+        result.assign(operands[0]);
+        return result;
+    }
+    case Op::Add: return Addition::apply(operands[0], operands[1]);
+    case Op::Sub: return Subtrbody::apply(operands[0], operands[1]);
+    case Op::Mul: return Multiplication::apply(operands[0], operands[1]);
+    case Op::Div:
+        if (is_integral(instruction.type) && operands[1].as<int64_t>() == 0)
+            return std::nullopt;
+        return Division::apply(operands[0], operands[1]);
+    case Op::Neg: return -Object(operands[0]);
+    case Op::LessThan: return LessThan::apply(operands[0], operands[1]);
+    case Op::LessEqual: return LessEqual::apply(operands[0], operands[1]);
+    case Op::GreaterThan: return GreaterThan::apply(operands[0], operands[1]);
+    case Op::GreaterEqual: return GreaterEqual::apply(operands[0], operands[1]);
+    case Op::Equal: return Equal::apply(operands[0], operands[1]);
+    case Op::NotEqual: return NotEqual::apply(operands[0], operands[1]);
+    case Op::Parameter:
+    case Op::Phi:
+    case Op::Call: break;
+    }
+    return std::nullopt;
+}
+
+std::optional<Object> run(const Function& function, const std::vector<Object>& args) {
+    LLC_CHECK(args.size() == function.parameters.size());
+
+    std::vector<Object> values(function.values.size());
+    std::vector<Object> operands, incoming;
+    int block = 0, previous = -1;
+    while (true) {
+        const Block& current = function.blocks[block];
+        LLC_CHECK(!current.removed);
+
+        // the phis of a block take the values of the predecessor all at once
+        size_t from = 0;
+        if (previous >= 0)
+            from = std::find(current.predecessors.begin(), current.predecessors.end(), previous) -
+                   current.predecessors.begin();
+        incoming.clear();
+        for (int id : current.instructions) {
+            if (!function.is_phi(id))
+                break;
+            incoming.push_back(values[function.values[id].operands[from]]);
+        }
+        for (size_t i = 0; i < incoming.size(); i++)
+            values[current.instructions[i]] = std::move(incoming[i]);
+
+        for (size_t i = incoming.size(); i < current.instructions.size(); i++) {
+            int id = current.instructions[i];
+            const Instruction& instruction = function.values[id];
+            operands.clear();
+            for (int operand : instruction.operands)
+                operands.push_back(values[operand]);
+
+            if (instruction.op == Op::Parameter) {
+                values[id] = zero(instruction.type);
+                values[id].assign(args[instruction.index]);
+            } else if (instruction.op == Op::Call) {
+                if (auto result = instruction.function->call(*function.scope, operands))
+                    values[id] = std::move(*result);
+            } else if (auto result = evaluate(instruction, operands)) {
+                values[id] = std::move(*result);
+            } else {
+                throw_exception("integer division by zero");
+            }
+        }
+
+        previous = block;
+        switch (current.exit) {
+        case Exit::Jump: block = current.targets[0]; break;
+        case Exit::Branch:
+            block = values[current.condition].as<bool>() ? current.targets[0] : current.targets[1];
+            break;
+        case Exit::Return:
+            if (current.value < 0)
+                return std::nullopt;
+            return values[current.value];
+        }
+    }
+}
+
+// "A Simple, Fast Dominance Algorithm" (Cooper, Harvey and Kennedy): the dominator of a block is
+// the nearest common dominator of its predecessors, found by walking up the tree built so far
+// while visiting the blocks in reverse postorder until nothing changes
+std::vector<int> dominators(const Function& function) {
+    size_t size = function.blocks.size();
+    std::vector<int> postorder, number(size, -1);
+    std::vector<bool> visited(size, false);
+    std::function<void(int)> visit = [&](int block) {
+        visited[block] = true;
+        for (int successor : function.blocks[block].successors())
+            if (!visited[successor])
+                visit(successor);
+        number[block] = (int)postorder.size();
+        postorder.push_back(block);
+    };
+    visit(0);
+
+    std::vector<int> idom(size, -1);
+    idom[0] = 0;
+    auto intersect = [&](int a, int b) {
+        while (a != b) {
+            while (number[a] < number[b])
+                a = idom[a];
+            while (number[b] < number[a])
+                b = idom[b];
+        }
+        return a;
+    };
+    bool changed = true;
+    while (changed) {
+        changed = false;
+        for (auto it = postorder.rbegin(); it != postorder.rend(); ++it) {
+            int block = *it;
+            if (block == 0)
+                continue;
+            int dominator = -1;
+            for (int predecessor : function.blocks[block].predecessors) {
+                if (number[predecessor] < 0 || idom[predecessor] < 0)
+                    continue;
+                dominator = dominator < 0 ? predecessor : intersect(predecessor, dominator);
+            }
+            if (dominator != idom[block]) {
+                idom[block] = dominator;
+                changed = true;
+            }
+        }
+    }
+    idom[0] = -1;
+    return idom;
+}
+
+void CopyPropagation::run(Function& function) {
+    bool changed = true;
+    while (changed) {
+        changed = false;
+        for (auto& block : function.blocks)
+            for (int id : std::vector<int>(block.instructions)) {
+                const Instruction& instruction = function.values[id];
+                int by = -1;
+                if (instruction.op == Op::Copy)
+                    by = instruction.operands[0];
+                else if (instruction.op == Op::Convert &&
+                         function.values[instruction.operands[0]].type == instruction.type)
+                    by = instruction.operands[0];
+                else if (instruction.op == Op::Phi)
+                    by = trivial_phi(function, id);
+                if (by >= 0) {
+                    function.replace(id, by);
+                    changed = true;
+                }
+            }
+    }
+}
+
+void SparseConditionalConstantPropagation::run(Function& function) {
+    enum class State { Unknown, Constant, Varying };
+    size_t size = function.values.size();
+    std::vector<State> states(size, State::Unknown);
+    std::vector<Object> constants(size);
+
+    // the instructions and the branches using each value
+    std::vector<std::vector<int>> users(size), branches(size);
+    for (int b = 0; b < (int)function.blocks.size(); b++) {
+        const Block& block = function.blocks[b];
+        for (int id : block.instructions)
+            for (int operand : function.values[id].operands)
+                users[operand].push_back(id);
+        if (!block.removed && block.exit == Exit::Branch)
+            branches[block.condition].push_back(b);
+    }
+
+    std::vector<bool> reachable(function.blocks.size(), false);
+    std::set<std::pair<int, int>> edges;
+    std::vector<std::pair<int, int>> flow = {{-1, 0}};
+    std::vector<int> changed;
+
+    auto visit = [&](int id) {
+        const Instruction& instruction = function.values[id];
+        State state = State::Unknown;
+        Object value;
+        if (instruction.op == Op::Parameter || instruction.op == Op::Call) {
+            state = State::Varying;
+        } else if (instruction.op == Op::Phi) {
+            // only the values coming from edges that can be taken count
+            const auto& predecessors = function.blocks[instruction.block].predecessors;
+            for (size_t i = 0; i < instruction.operands.size(); i++) {
+                int operand = instruction.operands[i];
+                if (!edges.count({predecessors[i], instruction.block}) ||
+                    states[operand] == State::Unknown)
+                    continue;
+                if (states[operand] == State::Varying ||
+                    (state == State::Constant && !same_constant(value, constants[operand]))) {
+                    state = State::Varying;
+                    break;
+                }
+                state = State::Constant;
+                value = constants[operand];
+            }
+        } else {
+            std::vector<Object> operands;
+            for (int operand : instruction.operands) {
+                if (states[operand] == State::Varying)
+                    state = State::Varying;
+                operands.push_back(constants[operand]);
+            }
+            bool known =
+                std::all_of(instruction.operands.begin(), instruction.operands.end(),
+                            [&](int operand) { return states[operand] == State::Constant; });
+            if (known) {
+                auto result = evaluate(instruction, operands);
+                state = result ? State::Constant : State::Varying;
+                if (result)
+                    value = std::move(*result);
+            }
+        }
+
+        if (state == states[id] &&
+            (state != State::Constant || same_constant(value, constants[id])))
+            return;
+        if (states[id] == State::Constant && state == State::Constant)
+            state = State::Varying;
+        states[id] = state;
+        constants[id] = std::move(value);
+        changed.push_back(id);
+    };
+    auto visit_exit = [&](int b) {
+        const Block& block = function.blocks[b];
+        if (block.exit == Exit::Jump) {
+            flow.push_back({b, block.targets[0]});
+        } else if (block.exit == Exit::Branch) {
+            State state = states[block.condition];
+            if (state == State::Constant)
+                flow.push_back(
+                    {b, block.targets[constants[block.condition].as<bool>() ? 0 : 1]});
+            else if (state == State::Varying) {
+                flow.push_back({b, block.targets[0]});
+                flow.push_back({b, block.targets[1]});
+            }
+        }
+    };
+
+    while (flow.size() || changed.size()) {
+        if (flow.size()) {
+            auto [from, to] = flow.back();
+            flow.pop_back();
+            if (from >= 0 && !edges.insert({from, to}).second)
+                continue;
+            const auto instructions = function.blocks[to].instructions;
+            for (int id : instructions)
+                if (function.is_phi(id))
+                    visit(id);
+            if (!reachable[to]) {
+                reachable[to] = true;
+                for (int id : instructions)
+                    if (!function.is_phi(id))
+                        visit(id);
+                visit_exit(to);
+            }
+            continue;
+        }
+
+        int id = changed.back();
+        changed.pop_back();
+        for (int user : users[id])
+            if (function.values[user].block >= 0 && reachable[function.values[user].block])
+                visit(user);
+        for (int block : branches[id])
+            if (reachable[block])
+                visit_exit(block);
+    }
+
+    for (int b = 0; b < (int)function.blocks.size(); b++)
+        if (!function.blocks[b].removed && !reachable[b])
+            function.remove_block(b);
+    for (int b = 0; b < (int)function.blocks.size(); b++) {
+        Block& block = function.blocks[b];
+        if (block.removed)
+            continue;
+        for (int predecessor : std::vector<int>(block.predecessors))
+            if (!edges.count({predecessor, b}))
+                function.remove_edge(predecessor, b);
+
+        for (int id : block.instructions) {
+            Instruction& instruction = function.values[id];
+            if (states[id] == State::Constant && instruction.op != Op::Constant) {
+                instruction.op = Op::Constant;
+                instruction.operands.clear();
+                instruction.constant = constants[id];
+            }
+        }
+        std::stable_partition(block.instructions.begin(), block.instructions.end(),
+                              [&](int id) { return function.is_phi(id); });
+
+        if (block.exit == Exit::Branch && states[block.condition] == State::Constant) {
+            block.exit = Exit::Jump;
+            block.targets[0] = block.targets[constants[block.condition].as<bool>() ? 0 : 1];
+            block.targets[1] = -1;
+            block.condition = -1;
+        }
+    }
+}
+
+void GlobalValueNumbering::run(Function& function) {
+    std::vector<int> idom = dominators(function);
+    std::vector<std::vector<int>> children(function.blocks.size());
+    for (int b = 0; b < (int)function.blocks.size(); b++)
+        if (idom[b] >= 0)
+            children[idom[b]].push_back(b);
+
+    // an operation is identified by its kind, type and operands, the operands of a commutative one
+    // in increasing order. phis are only the same as phis of the same block
+    using Key = std::tuple<Op, size_t, std::vector<int>, uint64_t, int>;
+    std::map<Key, int> available;
+
+    std::function<void(int)> visit = [&](int b) {
+        std::vector<Key> added;
+        for (int id : std::vector<int>(function.blocks[b].instructions)) {
+            const Instruction& instruction = function.values[id];
+            if (instruction.op == Op::Call)
+                continue;
+            if (instruction.op == Op::Phi) {
+                int same = trivial_phi(function, id);
+                if (same >= 0) {
+                    function.replace(id, same);
+                    continue;
+                }
+            }
+
+            Key key{instruction.op, instruction.type, instruction.operands, 0, -1};
+            if (instruction.op == Op::Constant)
+                std::get<3>(key) = bits_of(instruction.constant);
+            else if (instruction.op == Op::Parameter)
+                std::get<3>(key) = instruction.index;
+            else if (instruction.op == Op::Phi)
+                std::get<4>(key) = b;
+            if (instruction.op == Op::Add || instruction.op == Op::Mul ||
+                instruction.op == Op::Equal || instruction.op == Op::NotEqual)
+                std::sort(std::get<2>(key).begin(), std::get<2>(key).end());
+
+            auto found = available.find(key);
+            if (found != available.end()) {
+                function.replace(id, found->second);
+            } else {
+                available.emplace(key, id);
+                added.push_back(std::move(key));
+            }
+        }
+        for (int child : children[b])
+            visit(child);
+        for (const auto& key : added)
+            available.erase(key);
+    };
+    visit(0);
+}
+
+void DeadCodeElimination::run(Function& function) {
+    std::vector<bool> reachable(function.blocks.size(), false);
+    std::vector<int> blocks = {0};
+    reachable[0] = true;
+    while (blocks.size()) {
+        int block = blocks.back();
+        blocks.pop_back();
+        for (int successor : function.blocks[block].successors())
+            if (!reachable[successor]) {
+                reachable[successor] = true;
+                blocks.push_back(successor);
+            }
+    }
+    for (int b = 0; b < (int)function.blocks.size(); b++)
+        if (!function.blocks[b].removed && !reachable[b])
+            function.remove_block(b);
+
+    // a block only reached by a jump from its predecessor continues that block
+    bool merged = true;
+    while (merged) {
+        merged = false;
+        for (int b = 1; b < (int)function.blocks.size(); b++) {
+            Block& block = function.blocks[b];
+            if (block.removed || block.predecessors.size() != 1)
+                continue;
+            int predecessor = block.predecessors[0];
+            Block& previous = function.blocks[predecessor];
+            if (predecessor == b || previous.exit != Exit::Jump)
+                continue;
+
+            for (int id : std::vector<int>(block.instructions))
+                if (function.is_phi(id))
+                    function.replace(id, function.values[id].operands[0]);
+            for (int id : block.instructions) {
+                function.values[id].block = predecessor;
+                previous.instructions.push_back(id);
+            }
+            for (int successor : block.successors())
+                for (int& from : function.blocks[successor].predecessors)
+                    if (from == b)
+                        from = predecessor;
+            previous.exit = block.exit;
+            previous.condition = block.condition;
+            previous.targets[0] = block.targets[0];
+            previous.targets[1] = block.targets[1];
+            previous.value = block.value;
+
+            block.instructions.clear();
+            block.predecessors.clear();
+            block.removed = true;
+            merged = true;
+        }
+    }
+
+    std::vector<bool> live(function.values.size(), false);
+    std::vector<int> work;
+    auto mark = [&](int id) {
+        if (id >= 0 && !live[id]) {
+            live[id] = true;
+            work.push_back(id);
+        }
+    };
+    for (const auto& block : function.blocks) {
+        if (block.removed)
+            continue;
+        for (int id : block.instructions)
+            if (function.values[id].op == Op::Call)
+                mark(id);
+        if (block.exit == Exit::Branch)
+            mark(block.condition);
+        if (block.exit == Exit::Return)
+            mark(block.value);
+    }
+    while (work.size()) {
+        int id = work.back();
+        work.pop_back();
+        for (int operand : function.values[id].operands)
+            mark(operand);
+    }
+
+    for (auto& block : function.blocks)
+        for (int id : std::vector<int>(block.instructions))
+            if (!live[id])
+                function.remove(id);
+}
+
+PassManager::PassManager() {
+    add(std::make_unique<CopyPropagation>());
+    add(std::make_unique<SparseConditionalConstantPropagation>());
+    add(std::make_unique<GlobalValueNumbering>());
+    add(std::make_unique<DeadCodeElimination>());
+}
+
+void PassManager::add(std::unique_ptr<Pass> pass) {
+    passes.push_back({std::move(pass), true});
+}
+
+PassManager::Entry& PassManager::find(const std::string& name) {
+    for (auto& entry : passes)
+        if (entry.pass->name() == name)
+            return entry;
+    throw_exception("no IR pass is named \"", name, '"');
+    return passes.front();
+}
+
+void PassManager::enable(const std::string& name, bool enabled) {
+    find(name).enabled = enabled;
+}
+
+bool PassManager::enabled(const std::string& name) const {
+    for (const auto& entry : passes)
+        if (entry.pass->name() == name)
+            return entry.enabled;
+    return false;
+}
+
+void PassManager::run(Function& function) const {
+    for (const auto& entry : passes)
+        if (entry.enabled)
+            entry.pass->run(function);
+}
+
+}  // namespace ir
+
+}  // namespace llc
@@ -0,0 +1,924 @@
+#include <llc/jit.h>
+
+#ifdef LLC_JIT_SUPPORTED
+
+#include <cstring>
+#include <map>
+#include <set>
+
+#include <sys/mman.h>
+#include <unistd.h>
+
+namespace llc {
+
+namespace {
+
+// thrown while generating code for a construct the jit does not handle, the function is then
+// left to the interpreter
+struct Unsupported {};
+
+enum class Type { Void, Bool, Int, Float, Double };
+
+Type native_type(const Object& object) {
+    if (object.is_void())
+        return Type::Void;
+    size_t id = object.type_id();
+    if (id == typeid_bool)
+        return Type::Bool;
+    if (id == typeid_int)
+        return Type::Int;
+    if (id == typeid_float)
+        return Type::Float;
+    if (id == typeid_double)
+        return Type::Double;
+    throw Unsupported();
+}
+
+// every literal the jit accepts is represented exactly by a double
+double literal_value(const NumberLiteral& literal) {
+    native_type(literal.value);
+    return literal.value.as<double>();
+}
+
+bool is_floating(Type type) {
+    return type == Type::Float || type == Type::Double;
+}
+
+struct Signature {
+    std::vector<Type> parameters;
+    Type result = Type::Void;
+};
+
+// every compiled function takes a pointer to its arguments, one 8 bytes cell each, in rdi and
+// returns the raw bits of its result in rax. compiled functions call each other through
+// "entries" so that the callee does not have to be placed before the caller
+using Entry = uint64_t (*)(const uint64_t* args);
+
+struct Module {
+    ~Module() {
+        if (memory != nullptr)
+            munmap(memory, size);
+    }
+
+    void* memory = nullptr;
+    size_t size = 0;
+    std::unique_ptr<void*[]> entries;
+};
+
+struct JitFunction : NativeFunction {
+    std::optional<Object> call(const std::vector<Object>& args) const override {
+        LLC_CHECK(args.size() == signature.parameters.size());
+
+        uint64_t buffer[8];
+        std::vector<uint64_t> overflow;
+        uint64_t* raw = buffer;
+        if (args.size() > 8) {
+            overflow.resize(args.size());
+            raw = overflow.data();
+        }
+
+        for (size_t i = 0; i < args.size(); i++) {
+            raw[i] = 0;
+            switch (signature.parameters[i]) {
+            case Type::Bool: raw[i] = args[i].as<bool>(); break;
+            case Type::Int: raw[i] = (uint32_t)args[i].as<int>(); break;
+            case Type::Float: {
+                float value = args[i].as<float>();
+                memcpy(&raw[i], &value, sizeof(value));
+                break;
+            }
+            case Type::Double: {
+                double value = args[i].as<double>();
+                memcpy(&raw[i], &value, sizeof(value));
+                break;
+            }
+            case Type::Void: LLC_CHECK(false);
+            }
+        }
+
+        uint64_t bits = ((Entry)module->entries[index])(raw);
+
+        switch (signature.result) {
+        case Type::Bool: return Object((bool)(bits & 1));
+        case Type::Int: return Object((int)(uint32_t)bits);
+        case Type::Float: {
+            float value;
+            uint32_t low = (uint32_t)bits;
+            memcpy(&value, &low, sizeof(value));
+            return Object(value);
+        }
+        case Type::Double: {
+            double value;
+            memcpy(&value, &bits, sizeof(value));
+            return Object(value);
+        }
+        case Type::Void: break;
+        }
+        return std::nullopt;
+    }
+
+    std::shared_ptr<Module> module;
+    int index = 0;
+    Signature signature;
+};
+
+enum Register { RAX = 0, RCX = 1, RSP = 4, RBP = 5, RDI = 7 };
+
+// emits the handful of x86-64 instructions the code generator needs. values being computed live
+// in the accumulator(eax for bool and int, xmm0 for float and double), binary operators take their
+// right hand side from the secondary register(ecx or xmm1)
+struct Assembler {
+    template <typename... Bytes>
+    void emit(Bytes... bytes) {
+        (code.push_back((uint8_t)bytes), ...);
+    }
+    void imm32(uint32_t value) {
+        for (int i = 0; i < 4; i++)
+            code.push_back((uint8_t)(value >> (i * 8)));
+    }
+    void imm64(uint64_t value) {
+        for (int i = 0; i < 8; i++)
+            code.push_back((uint8_t)(value >> (i * 8)));
+    }
+    // [base + disp32] operand with "reg" in the reg field of modrm
+    void memory(int reg, int base, int32_t disp) {
+        emit(0x80 | (reg & 7) << 3 | (base & 7));
+        if ((base & 7) == RSP)
+            emit(0x24);
+        imm32(disp);
+    }
+
+    int here() const {
+        return (int)code.size();
+    }
+    // emits a jump with a rel32 placeholder, returns the location to patch
+    int jump() {
+        emit(0xe9);
+        imm32(0);
+        return here() - 4;
+    }
+    int jump_if(uint8_t condition) {
+        emit(0x0f, 0x80 | condition);
+        imm32(0);
+        return here() - 4;
+    }
+    void patch(int location, int target) {
+        int32_t rel = target - (location + 4);
+        memcpy(&code[location], &rel, sizeof(rel));
+    }
+    void jump_to(int target) {
+        patch(jump(), target);
+    }
+
+    void load(Type type, int32_t disp, bool secondary = false) {
+        int reg = secondary ? RCX : RAX;
+        if (type == Type::Float)
+            emit(0xf3, 0x0f, 0x10);
+        else if (type == Type::Double)
+            emit(0xf2, 0x0f, 0x10);
+        else
+            emit(0x8b);
+        memory(reg, RBP, disp);
+    }
+    void store(Type type, int base, int32_t disp, int reg = RAX) {
+        if (type == Type::Float)
+            emit(0xf3, 0x0f, 0x11);
+        else if (type == Type::Double)
+            emit(0xf2, 0x0f, 0x11);
+        else
+            emit(0x89);
+        memory(reg, base, disp);
+    }
+    void constant(Type type, double value, bool secondary = false) {
+        int reg = secondary ? RCX : RAX;
+        switch (type) {
+        case Type::Bool:
+            emit(0xb8 + reg);
+            imm32((bool)value);
+            break;
+        case Type::Int:
+            emit(0xb8 + reg);
+            imm32((uint32_t)(int)value);
+            break;
+        case Type::Float: {
+            float narrowed = (float)value;
+            uint32_t bits;
+            memcpy(&bits, &narrowed, sizeof(bits));
+            emit(0x41, 0xbb);  // mov r11d, imm32
+            imm32(bits);
+            emit(0x66, 0x41, 0x0f, 0x6e, 0xc3 | reg << 3);  // movd xmm, r11d
+            break;
+        }
+        case Type::Double: {
+            uint64_t bits;
+            memcpy(&bits, &value, sizeof(bits));
+            emit(0x49, 0xbb);  // mov r11, imm64
+            imm64(bits);
+            emit(0x66, 0x49, 0x0f, 0x6e, 0xc3 | reg << 3);  // movq xmm, r11
+            break;
+        }
+        case Type::Void: throw Unsupported();
+        }
+    }
+
+    void push(Type type) {
+        if (is_floating(type))
+            emit(0x48, 0x83, 0xec, 0x08, 0xf2, 0x0f, 0x11, 0x04, 0x24);
+        else
+            emit(0x50);
+    }
+    void pop(Type type) {
+        if (is_floating(type))
+            emit(0xf2, 0x0f, 0x10, 0x04, 0x24, 0x48, 0x83, 0xc4, 0x08);
+        else
+            emit(0x58);
+    }
+    void to_secondary(Type type) {
+        if (is_floating(type))
+            emit(0x0f, 0x28, 0xc8);  // movaps xmm1, xmm0
+        else
+            emit(0x89, 0xc1);  // mov ecx, eax
+    }
+    // moves the accumulator to and from the raw bits in rax
+    void to_raw(Type type) {
+        if (type == Type::Float)
+            emit(0x66, 0x0f, 0x7e, 0xc0);
+        else if (type == Type::Double)
+            emit(0x66, 0x48, 0x0f, 0x7e, 0xc0);
+    }
+    void from_raw(Type type) {
+        if (type == Type::Float)
+            emit(0x66, 0x0f, 0x6e, 0xc0);
+        else if (type == Type::Double)
+            emit(0x66, 0x48, 0x0f, 0x6e, 0xc0);
+    }
+
+    // same conversions as BaseObject::as between fundamental types
+    void convert(Type from, Type to) {
+        if (from == Type::Void || to == Type::Void)
+            throw Unsupported();
+        if (from == to || (from == Type::Bool && to == Type::Int))
+            return;
+
+        if (to == Type::Bool) {
+            if (from == Type::Int) {
+                emit(0x85, 0xc0);  // test eax, eax
+                emit(0x0f, 0x95, 0xc0);
+            } else {
+                emit(0x0f, 0x57, 0xc9);  // xorps xmm1, xmm1
+                if (from == Type::Double)
+                    emit(0x66);
+                emit(0x0f, 0x2e, 0xc1);  // ucomis xmm0, xmm1
+                emit(0x0f, 0x95, 0xc0);  // setne al
+                emit(0x0f, 0x9a, 0xc1);  // setp cl
+                emit(0x08, 0xc8);        // or al, cl
+            }
+            emit(0x0f, 0xb6, 0xc0);
+        } else if (to == Type::Int) {
+            emit(from == Type::Float ? 0xf3 : 0xf2, 0x0f, 0x2c, 0xc0);  // cvtts*2si eax, xmm0
+        } else if (from == Type::Int || from == Type::Bool) {
+            emit(to == Type::Float ? 0xf3 : 0xf2, 0x0f, 0x2a, 0xc0);  // cvtsi2s* xmm0, eax
+        } else {
+            emit(from == Type::Float ? 0xf3 : 0xf2, 0x0f, 0x5a, 0xc0);  // cvts*2s* xmm0, xmm0
+        }
+    }
+
+    // accumulator = accumulator op secondary
+    void arithmetic(char op, Type type) {
+        if (is_floating(type)) {
+            uint8_t opcode = op == '+' ? 0x58 : op == '-' ? 0x5c : op == '*' ? 0x59 : 0x5e;
+            emit(type == Type::Float ? 0xf3 : 0xf2, 0x0f, opcode, 0xc1);
+        } else if (op == '+') {
+            emit(0x01, 0xc8);
+        } else if (op == '-') {
+            emit(0x29, 0xc8);
+        } else if (op == '*') {
+            emit(0x0f, 0xaf, 0xc1);
+        } else {
+            emit(0x99, 0xf7, 0xf9);  // cdq, idiv ecx
+        }
+    }
+    void negate(Type type) {
+        if (type == Type::Int) {
+            emit(0xf7, 0xd8);
+        } else if (type == Type::Float) {
+            emit(0x41, 0xbb);
+            imm32(0x80000000u);
+            emit(0x66, 0x41, 0x0f, 0x6e, 0xcb, 0x0f, 0x57, 0xc1);  // movd xmm1, r11d; xorps
+        } else {
+            emit(0x49, 0xbb);
+            imm64(0x8000000000000000ull);
+            emit(0x66, 0x49, 0x0f, 0x6e, 0xcb, 0x66, 0x0f, 0x57, 0xc1);  // movq xmm1, r11; xorpd
+        }
+    }
+
+    std::vector<uint8_t> code;
+};
+
+enum class Comparison { Less, LessEqual, Greater, GreaterEqual, Equal, NotEqual };
+
+// condition codes for which the comparison holds, for integers and for ucomis with the operands
+// already ordered by "compare" below
+uint8_t integer_condition(Comparison comparison) {
+    switch (comparison) {
+    case Comparison::Less: return 0xc;
+    case Comparison::LessEqual: return 0xe;
+    case Comparison::Greater: return 0xf;
+    case Comparison::GreaterEqual: return 0xd;
+    case Comparison::Equal: return 0x4;
+    case Comparison::NotEqual: return 0x5;
+    }
+    return 0;
+}
+uint8_t floating_condition(Comparison comparison) {
+    return comparison == Comparison::Less || comparison == Comparison::Greater ? 0x7 : 0x3;
+}
+
+bool always_returns(const Scope& scope) {
+    if (scope.statements.empty())
+        return false;
+    auto last = scope.statements.back().get();
+    if (dynamic_cast<Return*>(last))
+        return true;
+    if (auto block = dynamic_cast<Scope*>(last))
+        return always_returns(*block);
+    if (auto chain = dynamic_cast<IfElseChain*>(last)) {
+        if (chain->bodys.size() != chain->conditions.size() + 1)
+            return false;
+        for (const auto& body : chain->bodys)
+            if (!always_returns(*body))
+                return false;
+        return true;
+    }
+    return false;
+}
+
+struct Candidate {
+    Function* function;
+    InternalFunction* internal;
+    Signature signature;
+    bool compiled = true;
+    std::vector<uint8_t> code;
+};
+
+struct FunctionCompiler {
+    FunctionCompiler(const Candidate& candidate, const std::vector<Candidate>& candidates,
+                     const std::map<const Function*, int>& indices, void** entries)
+        : candidate(candidate), candidates(candidates), indices(indices), entries(entries){};
+
+    std::vector<uint8_t> compile() {
+        const Scope& definition = *candidate.internal->definition;
+        if (candidate.signature.result != Type::Void && !always_returns(definition))
+            throw Unsupported();
+
+        // every bool, int, float or double local of the frame gets an 8 bytes slot below rbp,
+        // others are rejected once they are referenced
+        int32_t frame = 0;
+        for (int i = 0; i < (int)definition.frame.size(); i++) {
+            try {
+                Type type = native_type(definition.frame[i]);
+                if (type != Type::Void)
+                    slots[i] = {-(frame += 8), type};
+            } catch (const Unsupported&) {
+            }
+        }
+
+        as.emit(0x55, 0x48, 0x89, 0xe5);  // push rbp; mov rbp, rsp
+        as.emit(0x48, 0x81, 0xec);        // sub rsp, imm32
+        as.imm32((frame + 15) / 16 * 16);
+
+        int parameters = (int)candidate.internal->parameters.size();
+        for (int i = 0; i < parameters; i++) {
+            auto slot = slots.find(i);
+            if (slot == slots.end())
+                throw Unsupported();
+            as.emit(0x48, 0x8b);  // mov rax, [rdi + 8 * i]
+            as.memory(RAX, RDI, 8 * i);
+            as.emit(0x48, 0x89);  // mov [rbp + slot], rax
+            as.memory(RAX, RBP, slot->second.disp);
+        }
+        // locals start from the default value of their type, like on the first interpreted call
+        body = as.here();
+        as.emit(0x31, 0xc0);
+        for (const auto& slot : slots)
+            if (slot.first >= parameters) {
+                as.emit(0x48, 0x89);
+                as.memory(RAX, RBP, slot.second.disp);
+            }
+
+        emit_scope(definition);
+
+        as.emit(0x31, 0xc0);
+        for (int location : returns)
+            as.patch(location, as.here());
+        as.emit(0x48, 0x89, 0xec, 0x5d, 0xc3);  // mov rsp, rbp; pop rbp; ret
+
+        return std::move(as.code);
+    }
+
+  private:
+    struct Slot {
+        int32_t disp;
+        Type type;
+    };
+
+    void emit_scope(const Scope& scope) {
+        for (const auto& statement : scope.statements)
+            emit_statement(statement, scope);
+    }
+
+    void emit_statement(const std::shared_ptr<Statement>& statement, const Scope& scope) {
+        if (auto expression = dynamic_cast<Expression*>(statement.get())) {
+            emit_effect(*expression, scope);
+
+        } else if (auto call = dynamic_cast<FunctionCall*>(statement.get())) {
+            emit_call(*call, scope);
+
+        } else if (auto ret = dynamic_cast<Return*>(statement.get())) {
+            if (ret->tail_call &&
+                scope.find_function(ret->tail_call->function_name) == candidate.function)
+                return emit_tail_call(*ret->tail_call, scope);
+
+            Type result = candidate.signature.result;
+            if (result == Type::Void) {
+                if (ret->expression.operands.size())
+                    throw Unsupported();
+            } else {
+                if (ret->expression.operands.empty())
+                    throw Unsupported();
+                as.convert(emit_expression(ret->expression, scope), result);
+                as.to_raw(result);
+            }
+            returns.push_back(as.jump());
+
+        } else if (dynamic_cast<Break*>(statement.get())) {
+            if (breaks.empty())
+                throw Unsupported();
+            breaks.back().push_back(as.jump());
+
+        } else if (auto chain = dynamic_cast<IfElseChain*>(statement.get())) {
+            std::vector<int> ends;
+            for (size_t i = 0; i < chain->conditions.size(); i++) {
+                int next = emit_branch_if_false(chain->conditions[i], scope);
+                emit_scope(*chain->bodys[i]);
+                ends.push_back(as.jump());
+                as.patch(next, as.here());
+            }
+            if (chain->bodys.size() == chain->conditions.size() + 1)
+                emit_scope(*chain->bodys.back());
+            for (int location : ends)
+                as.patch(location, as.here());
+
+        } else if (auto loop = dynamic_cast<For*>(statement.get())) {
+            const Scope& internal = *loop->internal_scope;
+            emit_effect(loop->initialization, internal);
+            int top = as.here();
+            std::vector<int> exits;
+            if (loop->condition.operands.size())
+                exits.push_back(emit_branch_if_false(loop->condition, internal));
+            breaks.emplace_back();
+            emit_scope(*loop->body);
+            emit_effect(loop->updation, internal);
+            as.jump_to(top);
+            for (int location : breaks.back())
+                exits.push_back(location);
+            breaks.pop_back();
+            for (int location : exits)
+                as.patch(location, as.here());
+
+        } else if (auto loop = dynamic_cast<While*>(statement.get())) {
+            int top = as.here();
+            std::vector<int> exits = {emit_branch_if_false(loop->condition, scope)};
+            breaks.emplace_back();
+            emit_scope(*loop->body);
+            as.jump_to(top);
+            for (int location : breaks.back())
+                exits.push_back(location);
+            breaks.pop_back();
+            for (int location : exits)
+                as.patch(location, as.here());
+
+        } else if (auto block = dynamic_cast<Scope*>(statement.get())) {
+            emit_scope(*block);
+
+        } else {
+            throw Unsupported();
+        }
+    }
+
+    void emit_effect(const Expression& expression, const Scope& scope) {
+        if (expression.operands.size())
+            emit_expression(expression, scope);
+    }
+
+    Type emit_expression(const Expression& expression, const Scope& scope) {
+        if (expression.operands.size() != 1)
+            throw Unsupported();
+        return emit_operand(expression.operands[0], scope);
+    }
+
+    // returns the location of the jump taken when the condition does not hold
+    int emit_branch_if_false(const Expression& expression, const Scope& scope) {
+        if (expression.operands.size() != 1)
+            throw Unsupported();
+        auto binary = dynamic_cast<BinaryOp*>(expression.operands[0].get());
+        auto comparison = binary ? comparison_of(*binary) : std::nullopt;
+        if (comparison && *comparison != Comparison::Equal &&
+            *comparison != Comparison::NotEqual) {
+            Type type = emit_compare(*binary, *comparison, scope);
+            if (is_floating(type))
+                return as.jump_if(floating_condition(*comparison) ^ 1);
+            return as.jump_if(integer_condition(*comparison) ^ 1);
+        }
+
+        as.convert(emit_expression(expression, scope), Type::Bool);
+        as.emit(0x85, 0xc0);
+        return as.jump_if(0x4);
+    }
+
+    std::optional<Comparison> comparison_of(const BinaryOp& binary) {
+        if (dynamic_cast<const LessThan*>(&binary))
+            return Comparison::Less;
+        if (dynamic_cast<const LessEqual*>(&binary))
+            return Comparison::LessEqual;
+        if (dynamic_cast<const GreaterThan*>(&binary))
+            return Comparison::Greater;
+        if (dynamic_cast<const GreaterEqual*>(&binary))
+            return Comparison::GreaterEqual;
+        if (dynamic_cast<const Equal*>(&binary))
+            return Comparison::Equal;
+        if (dynamic_cast<const NotEqual*>(&binary))
+            return Comparison::NotEqual;
+        return std::nullopt;
+    }
+
+    std::optional<char> arithmetic_of(const BinaryOp& binary, bool& compound) {
+        compound = false;
+        if (dynamic_cast<const Addition*>(&binary))
+            return '+';
+        if (dynamic_cast<const Subtrbody*>(&binary))
+            return '-';
+        if (dynamic_cast<const Multiplication*>(&binary))
+            return '*';
+        if (dynamic_cast<const Division*>(&binary))
+            return '/';
+        compound = true;
+        if (dynamic_cast<const AddEqual*>(&binary))
+            return '+';
+        if (dynamic_cast<const SubtractEqual*>(&binary))
+            return '-';
+        if (dynamic_cast<const MultiplyEqual*>(&binary))
+            return '*';
+        if (dynamic_cast<const DivideEqual*>(&binary))
+            return '/';
+        return std::nullopt;
+    }
+
+    Type emit_operand(const std::shared_ptr<Operand>& operand, const Scope& scope) {
+        if (auto literal = dynamic_cast<NumberLiteral*>(operand.get())) {
+            Type type = native_type(literal->value);
+            as.constant(type, literal_value(*literal));
+            return type;
+        }
+
+        if (dynamic_cast<VariableOp*>(operand.get())) {
+            const Slot& slot = resolve(operand, scope);
+            as.load(slot.type, slot.disp);
+            return slot.type;
+        }
+
+        if (auto call = dynamic_cast<FunctionCallOp*>(operand.get()))
+            return emit_call(call->function, scope);
+
+        if (auto assignment = dynamic_cast<Assignment*>(operand.get())) {
+            const Slot& slot = resolve(assignment->a, scope);
+            as.convert(emit_operand(assignment->b, scope), slot.type);
+            as.store(slot.type, RBP, slot.disp);
+            return slot.type;
+        }
+
+        if (auto binary = dynamic_cast<BinaryOp*>(operand.get())) {
+            if (auto comparison = comparison_of(*binary)) {
+                Type type = emit_compare(*binary, *comparison, scope);
+                if (!is_floating(type)) {
+                    as.emit(0x0f, 0x90 | integer_condition(*comparison), 0xc0);
+                } else if (*comparison == Comparison::Equal) {
+                    as.emit(0x0f, 0x94, 0xc0, 0x0f, 0x9b, 0xc1, 0x20, 0xc8);  // e && np
+                } else if (*comparison == Comparison::NotEqual) {
+                    as.emit(0x0f, 0x95, 0xc0, 0x0f, 0x9a, 0xc1, 0x08, 0xc8);  // ne || p
+                } else {
+                    as.emit(0x0f, 0x90 | floating_condition(*comparison), 0xc0);
+                }
+                as.emit(0x0f, 0xb6, 0xc0);
+                return Type::Bool;
+            }
+
+            bool compound;
+            auto op = arithmetic_of(*binary, compound);
+            if (!op)
+                throw Unsupported();
+
+            if (compound) {
+                const Slot& slot = resolve(binary->a, scope);
+                if (slot.type == Type::Bool)
+                    throw Unsupported();
+                if (auto literal = dynamic_cast<NumberLiteral*>(binary->b.get())) {
+                    as.load(slot.type, slot.disp);
+                    as.constant(slot.type, literal_value(*literal), true);
+                } else {
+                    as.convert(emit_operand(binary->b, scope), slot.type);
+                    as.to_secondary(slot.type);
+                    as.load(slot.type, slot.disp);
+                }
+                as.arithmetic(*op, slot.type);
+                as.store(slot.type, RBP, slot.disp);
+                return slot.type;
+            }
+
+            Type type = emit_operand(binary->a, scope);
+            if (type == Type::Void || type == Type::Bool)
+                throw Unsupported();
+            emit_secondary(binary->b, type, scope);
+            as.arithmetic(*op, type);
+            return type;
+        }
+
+        bool increment = dynamic_cast<PreIncrement*>(operand.get()) ||
+                         dynamic_cast<PostIncrement*>(operand.get());
+        bool decrement = dynamic_cast<PreDecrement*>(operand.get()) ||
+                         dynamic_cast<PostDecrement*>(operand.get());
+        if (increment || decrement) {
+            bool post = dynamic_cast<PostUnaryOp*>(operand.get()) != nullptr;
+            auto target = post ? dynamic_cast<PostUnaryOp*>(operand.get())->operand
+                               : dynamic_cast<PreUnaryOp*>(operand.get())->operand;
+            const Slot& slot = resolve(target, scope);
+            if (slot.type == Type::Bool)
+                throw Unsupported();
+
+            // the updated value is computed into ecx or xmm2, leaving the old one in the accumulator
+            as.load(slot.type, slot.disp);
+            if (slot.type == Type::Int) {
+                as.emit(0x89, 0xc1, 0x83, increment ? 0xc1 : 0xe9, 0x01);  // ecx = eax +- 1
+                as.store(slot.type, RBP, slot.disp, RCX);
+            } else {
+                as.constant(slot.type, 1.0f, true);
+                as.emit(0x0f, 0x28, 0xd0);  // movaps xmm2, xmm0
+                as.emit(slot.type == Type::Float ? 0xf3 : 0xf2, 0x0f, increment ? 0x58 : 0x5c, 0xd1);
+                as.store(slot.type, RBP, slot.disp, 2);
+            }
+            if (!post)
+                as.load(slot.type, slot.disp);
+            return slot.type;
+        }
+
+        if (auto negation = dynamic_cast<Negation*>(operand.get())) {
+            Type type = emit_operand(negation->operand, scope);
+            if (type == Type::Void || type == Type::Bool)
+                throw Unsupported();
+            as.negate(type);
+            return type;
+        }
+
+        throw Unsupported();
+    }
+
+    // evaluates "rhs" converted to "type" into the secondary register, keeping the accumulator
+    void emit_secondary(const std::shared_ptr<Operand>& rhs, Type type, const Scope& scope) {
+        if (auto literal = dynamic_cast<NumberLiteral*>(rhs.get())) {
+            as.constant(type, literal_value(*literal), true);
+            return;
+        }
+        if (dynamic_cast<VariableOp*>(rhs.get())) {
+            const Slot& slot = resolve(rhs, scope);
+            if (slot.type == type) {
+                as.load(type, slot.disp, true);
+                return;
+            }
+        }
+
+        as.push(type);
+        as.convert(emit_operand(rhs, scope), type);
+        as.to_secondary(type);
+        as.pop(type);
+    }
+
+    // compares in the type of the left hand side and leaves the flags set, floating point
+    // operands are swapped for < and <= so that unordered results compare false
+    Type emit_compare(const BinaryOp& binary, Comparison comparison, const Scope& scope) {
+        Type type = emit_operand(binary.a, scope);
+        if (type == Type::Void)
+            throw Unsupported();
+        emit_secondary(binary.b, type, scope);
+
+        if (!is_floating(type)) {
+            as.emit(0x39, 0xc8);  // cmp eax, ecx
+        } else {
+            if (type == Type::Double)
+                as.emit(0x66);
+            bool swap = comparison == Comparison::Less || comparison == Comparison::LessEqual;
+            as.emit(0x0f, 0x2e, swap ? 0xc8 : 0xc1);
+        }
+        return type;
+    }
+
+    Type emit_call(const FunctionCall& call, const Scope& scope) {
+        auto it = indices.find(scope.find_function(call.function_name));
+        if (it == indices.end() || !candidates[it->second].compiled)
+            throw Unsupported();
+        const Signature& callee = candidates[it->second].signature;
+        if (call.arguments.size() != callee.parameters.size())
+            throw Unsupported();
+
+        // arguments are stored right above rsp in the order they are evaluated, temporaries
+        // pushed while computing one of them are popped before it is stored
+        int32_t size = (int32_t)(8 * ((call.arguments.size() + 1) / 2 * 2));
+        if (size) {
+            as.emit(0x48, 0x81, 0xec);
+            as.imm32(size);
+        }
+        for (size_t i = 0; i < call.arguments.size(); i++) {
+            as.convert(emit_expression(call.arguments[i], scope), callee.parameters[i]);
+            as.store(callee.parameters[i], RSP, (int32_t)(8 * i));
+        }
+        as.emit(0x48, 0x89, 0xe7);  // mov rdi, rsp
+        as.emit(0x48, 0xb8);        // mov rax, &entries[callee]
+        as.imm64((uint64_t)&entries[it->second]);
+        as.emit(0xff, 0x10);  // call [rax]
+        if (size) {
+            as.emit(0x48, 0x81, 0xc4);
+            as.imm32(size);
+        }
+
+        as.from_raw(callee.result);
+        return callee.result;
+    }
+
+    // a call of the function itself in tail position overwrites the parameters and jumps back to
+    // the start of the body instead of growing the native stack
+    void emit_tail_call(const FunctionCall& call, const Scope& scope) {
+        const auto& parameters = candidate.signature.parameters;
+        if (call.arguments.size() != parameters.size())
+            throw Unsupported();
+
+        int32_t size = (int32_t)(8 * ((parameters.size() + 1) / 2 * 2));
+        if (size) {
+            as.emit(0x48, 0x81, 0xec);
+            as.imm32(size);
+        }
+        for (size_t i = 0; i < parameters.size(); i++) {
+            as.convert(emit_expression(call.arguments[i], scope), parameters[i]);
+            as.store(parameters[i], RSP, (int32_t)(8 * i));
+        }
+        for (size_t i = 0; i < parameters.size(); i++) {
+            as.emit(0x48, 0x8b);  // mov rax, [rsp + 8 * i]
+            as.memory(RAX, RSP, (int32_t)(8 * i));
+            as.emit(0x48, 0x89);  // mov [rbp + slot], rax
+            as.memory(RAX, RBP, slots.at((int)i).disp);
+        }
+        if (size) {
+            as.emit(0x48, 0x81, 0xc4);
+            as.imm32(size);
+        }
+        as.jump_to(body);
+    }
+
+    const Slot& resolve(const std::shared_ptr<Operand>& operand, const Scope&) {
+        auto variable = dynamic_cast<VariableOp*>(operand.get());
+        // a variable found outside of the frame is a global or a member and not handled
+        if (variable == nullptr || variable->ref.local < 0)
+            throw Unsupported();
+        auto slot = slots.find(variable->ref.local);
+        if (slot == slots.end())
+            throw Unsupported();
+        return slot->second;
+    }
+
+    const Candidate& candidate;
+    const std::vector<Candidate>& candidates;
+    const std::map<const Function*, int>& indices;
+    void** entries;
+
+    Assembler as;
+    std::map<int, Slot> slots;
+    std::vector<std::vector<int>> breaks;
+    std::vector<int> returns;
+    int body = 0;
+};
+
+void collect_candidates(Scope* scope, std::set<Scope*>& visited,
+                        std::vector<Candidate>& candidates) {
+    if (!visited.insert(scope).second)
+        return;
+    for_each_block(scope, [&](Scope* block) {
+        for (auto& function : block->functions) {
+            auto internal = dynamic_cast<InternalFunction*>(function.second.base.get());
+            if (internal == nullptr || internal->definition == nullptr ||
+                !internal->definition->members.empty())
+                continue;
+            collect_candidates(internal->definition.get(), visited, candidates);
+
+            Candidate candidate;
+            candidate.function = &function.second;
+            candidate.internal = internal;
+            try {
+                const auto& variables = internal->definition->frame;
+                if (variables.size() < internal->parameters.size())
+                    throw Unsupported();
+                for (size_t i = 0; i < internal->parameters.size(); i++) {
+                    if (native_type(variables[i]) == Type::Void)
+                        throw Unsupported();
+                    candidate.signature.parameters.push_back(native_type(variables[i]));
+                }
+                candidate.signature.result = native_type(internal->return_type);
+            } catch (const Unsupported&) {
+                continue;
+            }
+            candidates.push_back(std::move(candidate));
+        }
+    });
+}
+
+}  // namespace
+
+void JitCompiler::compile(std::shared_ptr<Scope> scope) {
+    std::vector<Candidate> candidates;
+    std::set<Scope*> visited;
+    collect_candidates(scope.get(), visited, candidates);
+    if (candidates.empty())
+        return;
+
+    std::map<const Function*, int> indices;
+    for (int i = 0; i < (int)candidates.size(); i++)
+        indices[candidates[i].function] = i;
+
+    auto module = std::make_shared<Module>();
+    module->entries.reset(new void*[candidates.size()]());
+
+    // a function calling one that cannot be compiled cannot be compiled either, so repeat until
+    // the set of compiled functions stops shrinking
+    bool changed = true;
+    while (changed) {
+        changed = false;
+        for (auto& candidate : candidates) {
+            if (!candidate.compiled)
+                continue;
+            try {
+                candidate.code =
+                    FunctionCompiler(candidate, candidates, indices, module->entries.get())
+                        .compile();
+            } catch (const Unsupported&) {
+                candidate.compiled = false;
+                changed = true;
+            }
+        }
+    }
+
+    size_t size = 0;
+    for (const auto& candidate : candidates)
+        if (candidate.compiled)
+            size += (candidate.code.size() + 15) / 16 * 16;
+    if (size == 0)
+        return;
+    size_t page = (size_t)sysconf(_SC_PAGESIZE);
+    size = (size + page - 1) / page * page;
+
+    void* memory = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (memory == MAP_FAILED)
+        return;
+    module->memory = memory;
+    module->size = size;
+
+    size_t offset = 0;
+    for (int i = 0; i < (int)candidates.size(); i++) {
+        if (!candidates[i].compiled)
+            continue;
+        memcpy((uint8_t*)memory + offset, candidates[i].code.data(), candidates[i].code.size());
+        module->entries[i] = (uint8_t*)memory + offset;
+        offset += (candidates[i].code.size() + 15) / 16 * 16;
+    }
+    if (mprotect(memory, size, PROT_READ | PROT_EXEC) != 0)
+        return;
+
+    for (int i = 0; i < (int)candidates.size(); i++) {
+        if (!candidates[i].compiled)
+            continue;
+        auto function = std::make_shared<JitFunction>();
+        function->module = module;
+        function->index = i;
+        function->signature = candidates[i].signature;
+        candidates[i].internal->native = function;
+    }
+}
+
+}  // namespace llc
+
+#else
+
+namespace llc {
+
+void JitCompiler::compile(std::shared_ptr<Scope>) {
+}
+
+}  // namespace llc
+
+#endif  // LLC_JIT_SUPPORTED
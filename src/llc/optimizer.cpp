@@ -0,0 +1,925 @@
+#include <llc/optimizer.h>
+
+#include <algorithm>
+#include <map>
+#include <set>
+
+namespace llc {
+
+void for_each_expression(Statement* statement, Scope& scope,
+                         const std::function<void(Expression&, Scope&)>& visit) {
+    if (auto expression = dynamic_cast<Expression*>(statement)) {
+        visit(*expression, scope);
+    } else if (auto ret = dynamic_cast<Return*>(statement)) {
+        visit(ret->expression, scope);
+    } else if (auto call = dynamic_cast<FunctionCall*>(statement)) {
+        for (auto& argument : call->arguments)
+            visit(argument, scope);
+    } else if (auto chain = dynamic_cast<IfElseChain*>(statement)) {
+        for (auto& condition : chain->conditions)
+            visit(condition, scope);
+        for (const auto& body : chain->bodys)
+            for_each_expression(body.get(), visit);
+    } else if (auto loop = dynamic_cast<For*>(statement)) {
+        visit(loop->initialization, *loop->internal_scope);
+        visit(loop->condition, *loop->internal_scope);
+        visit(loop->updation, *loop->internal_scope);
+        for_each_expression(loop->body.get(), visit);
+    } else if (auto loop = dynamic_cast<While*>(statement)) {
+        visit(loop->condition, scope);
+        for_each_expression(loop->body.get(), visit);
+    } else if (auto block = dynamic_cast<Scope*>(statement)) {
+        for_each_expression(block, visit);
+    }
+}
+
+void for_each_expression(Scope* scope, const std::function<void(Expression&, Scope&)>& visit) {
+    if (scope == nullptr)
+        return;
+    for (const auto& statement : scope->statements)
+        for_each_expression(statement.get(), *scope, visit);
+}
+
+std::vector<std::pair<std::shared_ptr<Operand>*, bool>> children_of(Operand& operand,
+                                                                    bool written) {
+    std::vector<std::pair<std::shared_ptr<Operand>*, bool>> children;
+    auto add_arguments = [&](std::vector<Expression>& arguments) {
+        for (auto& argument : arguments)
+            for (auto& child : argument.operands)
+                children.push_back({&child, false});
+    };
+
+    Operand* op = &operand;
+    if (auto call = dynamic_cast<MemberFunctionCall*>(op)) {
+        children.push_back({&call->operand, true});
+        add_arguments(call->arguments);
+    } else if (auto binary = dynamic_cast<BinaryOp*>(op)) {
+        bool target = dynamic_cast<Assignment*>(op) || dynamic_cast<AddEqual*>(op) ||
+                      dynamic_cast<SubtractEqual*>(op) || dynamic_cast<MultiplyEqual*>(op) ||
+                      dynamic_cast<DivideEqual*>(op);
+        // the object of a member or an element is modified when the member or element is
+        bool part = dynamic_cast<MemberAccess*>(op) || dynamic_cast<ArrayAccess*>(op);
+        children.push_back({&binary->a, target || (part && written)});
+        if (!dynamic_cast<MemberAccess*>(op))
+            children.push_back({&binary->b, false});
+    } else if (auto unary = dynamic_cast<PreUnaryOp*>(op)) {
+        bool target = dynamic_cast<PreIncrement*>(op) || dynamic_cast<PreDecrement*>(op);
+        children.push_back({&unary->operand, target});
+    } else if (auto unary = dynamic_cast<PostUnaryOp*>(op)) {
+        bool target = dynamic_cast<PostIncrement*>(op) || dynamic_cast<PostDecrement*>(op);
+        children.push_back({&unary->operand, target});
+    } else if (auto type = dynamic_cast<TypeOp*>(op)) {
+        add_arguments(type->arguments);
+    } else if (auto call = dynamic_cast<FunctionCallOp*>(op)) {
+        add_arguments(call->function.arguments);
+    }
+
+    children.erase(std::remove_if(children.begin(), children.end(),
+                                  [](const auto& child) { return *child.first == nullptr; }),
+                   children.end());
+    return children;
+}
+
+void for_each_operand(std::shared_ptr<Operand>& operand,
+                      const std::function<void(std::shared_ptr<Operand>&, bool written)>& visit,
+                      bool written) {
+    if (operand == nullptr)
+        return;
+    for (const auto& [child, target] : children_of(*operand, written))
+        for_each_operand(*child, visit, target);
+    visit(operand, written);
+}
+
+namespace {
+
+bool is_literal(const Operand* operand) {
+    return dynamic_cast<const NumberLiteral*>(operand) || dynamic_cast<const CharLiteral*>(operand);
+}
+
+bool is_zero(const Object& value) {
+    return value.visit([](auto v) { return v == 0; });
+}
+
+// operators that only compute a value from their operands
+bool is_foldable(const Operand* op) {
+    if (auto binary = dynamic_cast<const BinaryOp*>(op)) {
+        bool arithmetic = dynamic_cast<const Addition*>(op) || dynamic_cast<const Subtrbody*>(op) ||
+                          dynamic_cast<const Multiplication*>(op) ||
+                          dynamic_cast<const Division*>(op) || dynamic_cast<const LessThan*>(op) ||
+                          dynamic_cast<const LessEqual*>(op) ||
+                          dynamic_cast<const GreaterThan*>(op) ||
+                          dynamic_cast<const GreaterEqual*>(op) || dynamic_cast<const Equal*>(op) ||
+                          dynamic_cast<const NotEqual*>(op);
+        return arithmetic && is_literal(binary->a.get()) && is_literal(binary->b.get());
+    }
+    if (auto negation = dynamic_cast<const Negation*>(op))
+        return is_literal(negation->operand.get());
+    // conversions to arithmetic types, e.g. "float(3)"
+    if (auto type = dynamic_cast<const TypeOp*>(op)) {
+        if (type->type.is_void() || type->type.kind == Object::Kind::Boxed ||
+            type->arguments.size() > 1)
+            return false;
+        for (const auto& argument : type->arguments)
+            if (argument.operands.size() != 1 || !is_literal(argument.operands[0].get()))
+                return false;
+        return true;
+    }
+    return false;
+}
+
+}  // namespace
+
+bool fold_constants(std::shared_ptr<Operand>& operand, const Scope& scope) {
+    bool folded = false;
+    for_each_operand(operand, [&](std::shared_ptr<Operand>& op, bool) {
+        if (!is_foldable(op.get()))
+            return;
+        // integer division by zero is left to fail when it runs, if it ever does
+        if (auto division = dynamic_cast<Division*>(op.get())) {
+            Object divisor = division->b->evaluate(scope);
+            if (is_zero(divisor) && divisor.kind != Object::Kind::Float &&
+                divisor.kind != Object::Kind::Double)
+                return;
+        }
+
+        Object value;
+        try {
+            value = op->evaluate(scope);
+        } catch (const Exception&) {
+            // so is an operation that fails, e.g. on mismatched types
+            return;
+        }
+        if (value.is_void() || value.kind == Object::Kind::Boxed)
+            return;
+        op = std::make_shared<NumberLiteral>(std::move(value));
+        folded = true;
+    });
+    return folded;
+}
+
+void ConstantFolding::run(std::shared_ptr<Scope> scope) {
+    for (Scope* entry : collect_entry_scopes(scope.get()))
+        for_each_expression(entry, [](Expression& expression, Scope& scope) {
+            for (auto& operand : expression.operands)
+                fold_constants(operand, scope);
+        });
+}
+
+namespace {
+
+// where a variable lives, as found from a use of it, or nullptr for members of methods and
+// names that do not resolve to a variable
+Object* variable_of(const Operand* operand, const Scope& scope) {
+    auto variable = dynamic_cast<const VariableOp*>(operand);
+    if (variable == nullptr || !variable->ref || variable->ref.member >= 0)
+        return nullptr;
+    return scope.find_variable(variable->name);
+}
+
+struct Uses {
+    int reads = 0;
+    int writes = 0;
+};
+
+void count_uses(Expression& expression, Scope& scope, std::map<Object*, Uses>& uses) {
+    for (auto& operand : expression.operands)
+        for_each_operand(operand, [&](std::shared_ptr<Operand>& op, bool written) {
+            if (Object* variable = variable_of(op.get(), scope)) {
+                if (written)
+                    uses[variable].writes++;
+                else
+                    uses[variable].reads++;
+            }
+        });
+}
+
+void count_uses(Statement* statement, Scope& scope, std::map<Object*, Uses>& uses) {
+    for_each_expression(statement, scope, [&](Expression& expression, Scope& scope) {
+        count_uses(expression, scope, uses);
+    });
+}
+
+// the variable declared in "scope" that "statement" assigns a literal to, with the value the
+// variable holds afterwards
+std::optional<std::pair<Object*, Object>> literal_assignment(const Statement* statement,
+                                                             Scope& scope) {
+    auto expression = dynamic_cast<const Expression*>(statement);
+    if (expression == nullptr || expression->operands.size() != 1)
+        return std::nullopt;
+    auto assignment = dynamic_cast<const Assignment*>(expression->operands[0].get());
+    if (assignment == nullptr || !is_literal(assignment->b.get()))
+        return std::nullopt;
+    auto variable = dynamic_cast<const VariableOp*>(assignment->a.get());
+    if (variable == nullptr)
+        return std::nullopt;
+    auto slot = scope.slots.find(variable->name);
+    if (slot == scope.slots.end() || variable_of(variable, scope) == nullptr)
+        return std::nullopt;
+
+    Object& declared = scope.variables[slot->second];
+    if (declared.is_void() || declared.kind == Object::Kind::Boxed)
+        return std::nullopt;
+    Object value = declared;
+    try {
+        value.assign(assignment->b->evaluate(scope));
+    } catch (const Exception&) {
+        return std::nullopt;
+    }
+    return std::make_pair(&declared, std::move(value));
+}
+
+}  // namespace
+
+void ConstantPropagation::run(std::shared_ptr<Scope> scope) {
+    std::vector<Scope*> entries = collect_entry_scopes(scope.get());
+
+    // a constant can make others constant, e.g. "y" in "int x = 2; int y = x * 3;"
+    while (true) {
+        std::map<Object*, Uses> uses;
+        for (Scope* entry : entries)
+            for_each_expression(entry, [&](Expression& expression, Scope& scope) {
+                count_uses(expression, scope, uses);
+            });
+
+        std::map<Object*, Object> constants;
+        for (Scope* entry : entries)
+            for_each_block(entry, [&](Scope* block) {
+                // counted from the last statement back, "later" holds the reads that come after
+                // the statement being looked at
+                std::map<Object*, Uses> later;
+                for (size_t i = block->statements.size(); i-- > 0;) {
+                    const auto& statement = block->statements[i];
+                    if (auto assignment = literal_assignment(statement.get(), *block)) {
+                        Object* variable = assignment->first;
+                        const Uses& all = uses[variable];
+                        if (all.writes == 1 && all.reads > 0 &&
+                            all.reads == later[variable].reads)
+                            constants.emplace(variable, std::move(assignment->second));
+                    }
+                    count_uses(statement.get(), *block, later);
+                }
+            });
+        if (constants.empty())
+            break;
+
+        for (Scope* entry : entries)
+            for_each_expression(entry, [&](Expression& expression, Scope& scope) {
+                for (auto& operand : expression.operands) {
+                    for_each_operand(operand, [&](std::shared_ptr<Operand>& op, bool written) {
+                        Object* variable = variable_of(op.get(), scope);
+                        auto constant = constants.find(variable);
+                        if (!written && constant != constants.end())
+                            op = std::make_shared<NumberLiteral>(constant->second);
+                    });
+                    fold_constants(operand, scope);
+                }
+            });
+    }
+}
+
+namespace {
+
+// the value of a condition that is a literal
+std::optional<bool> constant_condition(const Expression& condition, const Scope& scope) {
+    if (condition.operands.size() != 1 || !is_literal(condition.operands[0].get()))
+        return std::nullopt;
+    return condition.operands[0]->evaluate(scope).as<bool>();
+}
+
+// whether running "statement" never lets the statements after it run
+bool always_exits(const Statement* statement) {
+    if (dynamic_cast<const Return*>(statement) || dynamic_cast<const Break*>(statement))
+        return true;
+    if (auto block = dynamic_cast<const Scope*>(statement))
+        return std::any_of(block->statements.begin(), block->statements.end(),
+                           [](const auto& statement) { return always_exits(statement.get()); });
+    if (auto chain = dynamic_cast<const IfElseChain*>(statement))
+        return chain->bodys.size() == chain->conditions.size() + 1 &&
+               std::all_of(chain->bodys.begin(), chain->bodys.end(),
+                           [](const auto& body) { return always_exits(body.get()); });
+    return false;
+}
+
+// a loop without body whose header calls nothing and only writes the variables it declares
+bool is_empty_loop(For& loop) {
+    if (!loop.body->statements.empty() || loop.condition.operands.empty())
+        return false;
+    Scope& scope = *loop.internal_scope;
+    bool effects = false;
+    for (Expression* expression : {&loop.initialization, &loop.condition, &loop.updation})
+        for (auto& operand : expression->operands)
+            for_each_operand(operand, [&](std::shared_ptr<Operand>& op, bool written) {
+                Operand* node = op.get();
+                if (dynamic_cast<FunctionCallOp*>(node) ||
+                    dynamic_cast<MemberFunctionCall*>(node) || dynamic_cast<NewOp*>(node) ||
+                    (dynamic_cast<TypeOp*>(node) && node->static_type() >= num_arithmetic_types))
+                    effects = true;
+                if (written) {
+                    auto slot = dynamic_cast<VariableOp*>(node)
+                                    ? scope.slots.find(static_cast<VariableOp*>(node)->name)
+                                    : scope.slots.end();
+                    if (slot == scope.slots.end() ||
+                        variable_of(node, scope) != &scope.variables[slot->second])
+                        effects = true;
+                }
+            });
+    return !effects;
+}
+
+// "statement" as it remains once dead code is removed from it, or nullptr when nothing does
+std::shared_ptr<Statement> eliminate(const std::shared_ptr<Statement>& statement, Scope& scope);
+
+void eliminate(Scope& block) {
+    std::vector<std::shared_ptr<Statement>> statements;
+    for (const auto& statement : block.statements) {
+        if (auto remaining = eliminate(statement, block)) {
+            statements.push_back(remaining);
+            if (always_exits(remaining.get()))
+                break;
+        }
+    }
+    block.statements = std::move(statements);
+}
+
+std::shared_ptr<Statement> eliminate(const std::shared_ptr<Statement>& statement, Scope& scope) {
+    if (auto chain = dynamic_cast<IfElseChain*>(statement.get())) {
+        std::vector<Expression> conditions;
+        std::vector<std::shared_ptr<Scope>> bodys;
+        bool otherwise = true;
+        for (size_t i = 0; i < chain->conditions.size(); i++) {
+            std::optional<bool> value = constant_condition(chain->conditions[i], scope);
+            if (value == false)
+                continue;
+            if (value == true) {
+                // the branch always taken becomes the else branch
+                bodys.push_back(chain->bodys[i]);
+                otherwise = false;
+                break;
+            }
+            conditions.push_back(chain->conditions[i]);
+            bodys.push_back(chain->bodys[i]);
+        }
+        if (otherwise && chain->bodys.size() > chain->conditions.size())
+            bodys.push_back(chain->bodys.back());
+
+        for (const auto& body : bodys)
+            eliminate(*body);
+        if (conditions.empty())
+            return bodys.empty() ? nullptr : bodys[0];
+        chain->conditions = std::move(conditions);
+        chain->bodys = std::move(bodys);
+
+    } else if (auto loop = dynamic_cast<For*>(statement.get())) {
+        eliminate(*loop->body);
+        if (constant_condition(loop->condition, *loop->internal_scope) == false)
+            return loop->initialization.operands.empty()
+                       ? nullptr
+                       : std::make_shared<Expression>(loop->initialization);
+        if (is_empty_loop(*loop))
+            return nullptr;
+
+    } else if (auto loop = dynamic_cast<While*>(statement.get())) {
+        eliminate(*loop->body);
+        if (constant_condition(loop->condition, scope) == false)
+            return nullptr;
+
+    } else if (auto block = dynamic_cast<Scope*>(statement.get())) {
+        eliminate(*block);
+    }
+    return statement;
+}
+
+}  // namespace
+
+void DeadCodeElimination::run(std::shared_ptr<Scope> scope) {
+    for (Scope* entry : collect_entry_scopes(scope.get()))
+        eliminate(*entry);
+}
+
+namespace {
+
+// a variable by the block declaring it and its slot in that block
+using Declaration = std::pair<const Scope*, int>;
+
+std::optional<Declaration> declaration_of(const Operand* operand, const Scope& scope) {
+    auto variable = dynamic_cast<const VariableOp*>(operand);
+    if (variable == nullptr || !variable->ref || variable->ref.member >= 0)
+        return std::nullopt;
+    for (const Scope* current = &scope; current; current = current->parent.get()) {
+        auto it = current->slots.find(variable->name);
+        if (it != current->slots.end())
+            return Declaration(current, it->second);
+    }
+    return std::nullopt;
+}
+
+// the function a call runs, methods are found through the declared type of their object
+const Function* callee_of(const Operand* operand, const Scope& scope) {
+    if (auto call = dynamic_cast<const FunctionCallOp*>(operand))
+        return scope.find_function(call->function.function_name);
+    if (auto call = dynamic_cast<const MemberFunctionCall*>(operand)) {
+        auto variable = dynamic_cast<const VariableOp*>(call->operand.get());
+        if (variable == nullptr)
+            return nullptr;
+        Object* object = scope.find_variable(variable->name);
+        if (object == nullptr || object->base == nullptr)
+            return nullptr;
+        int index = object->base->method_index(call->function_name);
+        return index < 0 ? nullptr : &object->base->method_at(index);
+    }
+    return nullptr;
+}
+
+bool is_pure_call(const Operand* operand, const Scope& scope) {
+    const Function* function = callee_of(operand, scope);
+    return function && function->base && function->base->pure;
+}
+
+// what may change while a loop runs
+struct LoopEffects {
+    // the blocks of the loop, whose variables take new values on every iteration
+    std::set<const Scope*> blocks;
+    std::set<Declaration> written;
+    // whether the loop calls functions that are not pure, these may write any variable that is
+    // not in the frame of the running call
+    bool calls = false;
+};
+
+LoopEffects effects_of(Statement* loop, Scope& scope) {
+    LoopEffects effects;
+    auto add_block = [&](Scope* block) { effects.blocks.insert(block); };
+    if (auto loop_for = dynamic_cast<For*>(loop)) {
+        for_each_block(loop_for->internal_scope.get(), add_block);
+        for_each_block(loop_for->body.get(), add_block);
+    } else if (auto loop_while = dynamic_cast<While*>(loop)) {
+        for_each_block(loop_while->body.get(), add_block);
+    }
+
+    for_each_expression(loop, scope, [&](Expression& expression, Scope& use) {
+        for (auto& operand : expression.operands) {
+            // the object of a pure method is read, not modified
+            std::set<const Operand*> receivers;
+            for_each_operand(operand, [&](std::shared_ptr<Operand>& op, bool) {
+                bool call = dynamic_cast<FunctionCallOp*>(op.get()) ||
+                            dynamic_cast<MemberFunctionCall*>(op.get());
+                if (call && !is_pure_call(op.get(), use))
+                    effects.calls = true;
+                else if (auto method = dynamic_cast<MemberFunctionCall*>(op.get()))
+                    receivers.insert(method->operand.get());
+            });
+            for_each_operand(operand, [&](std::shared_ptr<Operand>& op, bool written) {
+                if (written && !receivers.count(op.get()))
+                    if (auto declaration = declaration_of(op.get(), use))
+                        effects.written.insert(*declaration);
+            });
+        }
+    });
+    return effects;
+}
+
+// whether every evaluation of "operand" during the loop gives the same value without effects
+bool is_invariant(const std::shared_ptr<Operand>& operand, const Scope& scope,
+                  const LoopEffects& effects) {
+    Operand* op = operand.get();
+    if (is_literal(op))
+        return true;
+    if (auto variable = dynamic_cast<VariableOp*>(op)) {
+        auto declaration = declaration_of(op, scope);
+        if (!declaration || effects.blocks.count(declaration->first) ||
+            effects.written.count(*declaration))
+            return false;
+        return !effects.calls || variable->ref.local >= 0;
+    }
+
+    bool call = dynamic_cast<FunctionCallOp*>(op) || dynamic_cast<MemberFunctionCall*>(op);
+    bool computation = dynamic_cast<Addition*>(op) || dynamic_cast<Subtrbody*>(op) ||
+                       dynamic_cast<Multiplication*>(op) || dynamic_cast<Division*>(op) ||
+                       dynamic_cast<LessThan*>(op) || dynamic_cast<LessEqual*>(op) ||
+                       dynamic_cast<GreaterThan*>(op) || dynamic_cast<GreaterEqual*>(op) ||
+                       dynamic_cast<Equal*>(op) || dynamic_cast<NotEqual*>(op) ||
+                       dynamic_cast<Negation*>(op) ||
+                       (dynamic_cast<TypeOp*>(op) && op->static_type() < num_arithmetic_types) ||
+                       (call && is_pure_call(op, scope));
+    if (!computation)
+        return false;
+
+    // the loop may not run at all, an integer division is only moved when it cannot fail
+    if (auto division = dynamic_cast<Division*>(op)) {
+        size_t type = division->static_type();
+        if (type != typeid_float && type != typeid_double) {
+            if (!is_literal(division->b.get()) || is_zero(division->b->evaluate(scope)))
+                return false;
+        }
+    }
+
+    for (const auto& [child, written] : children_of(*op))
+        if (!is_invariant(*child, scope, effects))
+            return false;
+    return true;
+}
+
+// the object a temporary of type "type" is declared with, void when the type is not builtin
+Object prototype_of(size_t type) {
+    for (const auto& builtin : builtin_types())
+        if (!builtin.second.is_void() && builtin.second.type_id() == type)
+            return builtin.second;
+    return Object();
+}
+
+struct Hoister {
+    // moves the invariant computations of "operand" into temporaries of "block" that
+    // "prelude" assigns before the loop
+    void hoist(std::shared_ptr<Operand>& operand, Scope& use) {
+        if (!is_literal(operand.get()) && !dynamic_cast<VariableOp*>(operand.get()) &&
+            is_invariant(operand, use, effects)) {
+            std::string name = "$invariant" + std::to_string(count++);
+            block.add_variable(name, prototype_of(operand->static_type()));
+
+            auto assignment = std::make_shared<Assignment>();
+            assignment->a = std::make_shared<VariableOp>(name);
+            assignment->b = operand;
+            auto statement = std::make_shared<Expression>();
+            statement->operands.push_back(assignment);
+            prelude.push_back(statement);
+
+            auto temporary = std::make_shared<VariableOp>(name);
+            temporary->resolve(use);
+            operand = temporary;
+            return;
+        }
+        for (const auto& [child, written] : children_of(*operand))
+            if (!written)
+                hoist(*child, use);
+    }
+    void hoist(Expression& expression, Scope& use) {
+        for (auto& operand : expression.operands)
+            hoist(operand, use);
+    }
+
+    Scope& block;
+    const LoopEffects& effects;
+    int& count;
+    std::vector<std::shared_ptr<Statement>> prelude;
+};
+
+// hoists out of the loops of "block" and of the blocks nested in it, outer loops first so that
+// computations move as far out as they can
+void hoist_loops(Scope& block, int& count) {
+    std::vector<std::shared_ptr<Statement>> statements;
+    for (const auto& statement : block.statements) {
+        std::shared_ptr<Scope> body;
+        if (auto loop = dynamic_cast<For*>(statement.get())) {
+            LoopEffects effects = effects_of(loop, block);
+            Hoister hoister{block, effects, count, {}};
+            hoister.hoist(loop->condition, *loop->internal_scope);
+            hoister.hoist(loop->updation, *loop->internal_scope);
+            for_each_expression(loop->body.get(), [&](Expression& expression, Scope& use) {
+                hoister.hoist(expression, use);
+            });
+            statements.insert(statements.end(), hoister.prelude.begin(), hoister.prelude.end());
+            body = loop->body;
+        } else if (auto loop = dynamic_cast<While*>(statement.get())) {
+            LoopEffects effects = effects_of(loop, block);
+            Hoister hoister{block, effects, count, {}};
+            hoister.hoist(loop->condition, block);
+            for_each_expression(loop->body.get(), [&](Expression& expression, Scope& use) {
+                hoister.hoist(expression, use);
+            });
+            statements.insert(statements.end(), hoister.prelude.begin(), hoister.prelude.end());
+            body = loop->body;
+        } else if (auto chain = dynamic_cast<IfElseChain*>(statement.get())) {
+            for (const auto& body : chain->bodys)
+                hoist_loops(*body, count);
+        } else if (auto nested = dynamic_cast<Scope*>(statement.get())) {
+            hoist_loops(*nested, count);
+        }
+        if (body)
+            hoist_loops(*body, count);
+        statements.push_back(statement);
+    }
+    block.statements = std::move(statements);
+}
+
+}  // namespace
+
+void LoopInvariantCodeMotion::run(std::shared_ptr<Scope> scope) {
+    std::vector<Scope*> entries = collect_entry_scopes(scope.get());
+    int count = 0;
+    for (Scope* entry : entries)
+        hoist_loops(*entry, count);
+    if (count == 0)
+        return;
+
+    // temporaries were declared, frames are laid out and variables bound again
+    for (Scope* entry : entries)
+        if (entry->function)
+            entry->allocate_frame();
+    for (Scope* entry : entries)
+        entry->resolve(*entry);
+}
+
+namespace {
+
+template <typename Node>
+bool copy_node(const Operand* operand, std::shared_ptr<Operand>& copy) {
+    auto node = dynamic_cast<const Node*>(operand);
+    if (node)
+        copy = std::make_shared<Node>(*node);
+    return node != nullptr;
+}
+
+// a copy of "operand" that shares no node with it, or nullptr when it holds an operator that is
+// not copied. specialized operators are copied as the generic one, resolve() specializes them again
+std::shared_ptr<Operand> copy_of(const std::shared_ptr<Operand>& operand) {
+    const Operand* op = operand.get();
+    std::shared_ptr<Operand> copy;
+    bool copied =
+        copy_node<NumberLiteral>(op, copy) || copy_node<CharLiteral>(op, copy) ||
+        copy_node<StringLiteral>(op, copy) || copy_node<VariableOp>(op, copy) ||
+        copy_node<MemberAccess>(op, copy) || copy_node<MemberFunctionCall>(op, copy) ||
+        copy_node<ArrayAccess>(op, copy) || copy_node<TypeOp>(op, copy) ||
+        copy_node<FunctionCallOp>(op, copy) || copy_node<Assignment>(op, copy) ||
+        copy_node<Addition>(op, copy) || copy_node<Subtrbody>(op, copy) ||
+        copy_node<Multiplication>(op, copy) || copy_node<Division>(op, copy) ||
+        copy_node<AddEqual>(op, copy) || copy_node<SubtractEqual>(op, copy) ||
+        copy_node<MultiplyEqual>(op, copy) || copy_node<DivideEqual>(op, copy) ||
+        copy_node<PreIncrement>(op, copy) || copy_node<PreDecrement>(op, copy) ||
+        copy_node<PostIncrement>(op, copy) || copy_node<PostDecrement>(op, copy) ||
+        copy_node<Negation>(op, copy) || copy_node<LessThan>(op, copy) ||
+        copy_node<LessEqual>(op, copy) || copy_node<GreaterThan>(op, copy) ||
+        copy_node<GreaterEqual>(op, copy) || copy_node<Equal>(op, copy) ||
+        copy_node<NotEqual>(op, copy);
+    if (!copied)
+        return nullptr;
+    for (const auto& [child, written] : children_of(*copy)) {
+        *child = copy_of(*child);
+        if (*child == nullptr)
+            return nullptr;
+    }
+    return copy;
+}
+
+bool is_free_of_effects(std::shared_ptr<Operand> operand, const Scope& scope) {
+    bool free = true;
+    for_each_operand(operand, [&](std::shared_ptr<Operand>& op, bool written) {
+        bool call = dynamic_cast<FunctionCallOp*>(op.get()) ||
+                    dynamic_cast<MemberFunctionCall*>(op.get());
+        if (written || dynamic_cast<NewOp*>(op.get()) || (call && !is_pure_call(op.get(), scope)))
+            free = false;
+    });
+    return free;
+}
+
+// "operand" of static type "from" converted to the type of "type" as assigning it would
+std::shared_ptr<Operand> converted(std::shared_ptr<Operand> operand, size_t from,
+                                   const Object& type) {
+    if (type.is_void())
+        return nullptr;
+    if (from == type.type_id())
+        return operand;
+    if (type.kind == Object::Kind::Boxed)
+        return nullptr;
+    auto conversion = std::make_shared<TypeOp>(type);
+    conversion->arguments.emplace_back();
+    conversion->arguments.back().operands.push_back(std::move(operand));
+    return conversion;
+}
+
+// the expression a call of "function" from "use" evaluates to once inlined, or nullptr when it is
+// not inlined. "receiver" is the object of a method call and "discarded" tells that the result
+// of the call is not used
+std::shared_ptr<Operand> inline_call(const Function* function,
+                                     const std::vector<Expression>& arguments,
+                                     const std::shared_ptr<Operand>* receiver, const Scope& use,
+                                     bool discarded, int threshold) {
+    auto internal =
+        function ? dynamic_cast<const InternalFunction*>(function->base.get()) : nullptr;
+    if (internal == nullptr || internal->definition == nullptr)
+        return nullptr;
+    const Scope& definition = *internal->definition;
+    bool method = !definition.members.empty();
+    size_t parameters = internal->parameters.size();
+    if (method != (receiver != nullptr) || definition.statements.size() != 1 ||
+        arguments.size() != parameters || definition.frame.size() != parameters)
+        return nullptr;
+
+    std::shared_ptr<Operand> body;
+    bool returns = false;
+    if (auto ret = dynamic_cast<Return*>(definition.statements[0].get())) {
+        if (ret->expression.operands.size() != 1)
+            return nullptr;
+        body = ret->expression.operands[0];
+        returns = true;
+    } else if (auto expression = dynamic_cast<Expression*>(definition.statements[0].get())) {
+        if (!discarded || expression->operands.size() != 1)
+            return nullptr;
+        body = expression->operands[0];
+    } else {
+        return nullptr;
+    }
+
+    std::shared_ptr<Operand> inlined = copy_of(body);
+    if (inlined == nullptr)
+        return nullptr;
+
+    int size = 0;
+    bool valid = true, writes = false, calls = false;
+    std::vector<int> uses(parameters, 0);
+    for_each_operand(inlined, [&](std::shared_ptr<Operand>& op, bool written) {
+        size++;
+        if (auto variable = dynamic_cast<VariableOp*>(op.get())) {
+            const VariableRef& ref = variable->ref;
+            if (ref.local >= 0) {
+                // a parameter that is modified is a variable of its own
+                if (ref.local >= (int)parameters || written)
+                    valid = false;
+                else
+                    uses[ref.local]++;
+            } else if (ref.member < 0 &&
+                       (ref.object == nullptr || use.find_variable(variable->name) != ref.object)) {
+                // the caller has a variable of the same name hiding the one of the body
+                valid = false;
+            }
+            writes |= written && ref.local < 0;
+        } else if (auto call = dynamic_cast<FunctionCallOp*>(op.get())) {
+            const std::string& name = call->function.function_name;
+            const Function* callee = definition.find_function(name);
+            // methods calling methods by name run on their own object, which is not inlined
+            if (method || callee == function || use.find_function(name) != callee)
+                valid = false;
+            calls |= !is_pure_call(op.get(), definition);
+        } else if (dynamic_cast<MemberFunctionCall*>(op.get())) {
+            if (callee_of(op.get(), definition) == function)
+                valid = false;
+            calls |= !is_pure_call(op.get(), definition);
+        } else if (dynamic_cast<NewOp*>(op.get())) {
+            valid = false;
+        }
+    });
+    if (!valid || size > threshold || (returns && writes))
+        return nullptr;
+
+    // arguments are evaluated once before the body runs. reading a local of the caller, which
+    // the body cannot reach, or a variable the body neither writes nor may change through calls
+    // is the same wherever it happens. other arguments are only moved to the single use of their
+    // parameter when neither they nor the body have effects
+    std::vector<std::shared_ptr<Operand>> values;
+    for (size_t i = 0; i < parameters; i++) {
+        if (arguments[i].operands.size() != 1)
+            return nullptr;
+        const auto& argument = arguments[i].operands[0];
+        size_t type = argument->static_type();
+        bool simple = is_literal(argument.get());
+        if (auto variable = dynamic_cast<const VariableOp*>(argument.get()))
+            simple = (variable->ref.local >= 0 && type < num_arithmetic_types) ||
+                     (!writes && !calls);
+        if (!simple && (uses[i] != 1 || writes || calls || !is_free_of_effects(argument, use)))
+            return nullptr;
+        auto value = copy_of(argument);
+        if (value == nullptr)
+            return nullptr;
+        values.push_back(converted(std::move(value), type, definition.frame[i]));
+        if (values.back() == nullptr)
+            return nullptr;
+    }
+
+    for_each_operand(inlined, [&](std::shared_ptr<Operand>& op, bool) {
+        auto variable = dynamic_cast<VariableOp*>(op.get());
+        if (variable == nullptr)
+            return;
+        if (variable->ref.local >= 0) {
+            op = copy_of(values[variable->ref.local]);
+        } else if (variable->ref.member >= 0) {
+            // the members of the object become members of the receiver
+            auto access = std::make_shared<MemberAccess>();
+            access->member_name = definition.members[variable->ref.member];
+            access->a = copy_of(*receiver);
+            access->b = std::make_shared<ObjectMember>(access->member_name);
+            op = access;
+        }
+    });
+    if (!returns || discarded)
+        return inlined;
+
+    // the result is converted to the return type, a member read has the type of the field
+    size_t type = body->static_type();
+    auto variable = dynamic_cast<VariableOp*>(body.get());
+    if (variable && variable->ref.member >= 0) {
+        auto object = use.find_variable(dynamic_cast<VariableOp*>(receiver->get())->name);
+        auto base = object ? dynamic_cast<InternalObject*>(object->base.get()) : nullptr;
+        if (base && variable->ref.member < (int)base->fields.size() &&
+            !base->fields[variable->ref.member].is_void())
+            type = base->fields[variable->ref.member].type_id();
+    }
+    return converted(std::move(inlined), type, internal->return_type);
+}
+
+std::shared_ptr<Operand> inline_operand(const std::shared_ptr<Operand>& operand, const Scope& use,
+                                        bool discarded, int threshold) {
+    if (auto call = dynamic_cast<FunctionCallOp*>(operand.get()))
+        return inline_call(use.find_function(call->function.function_name),
+                           call->function.arguments, nullptr, use, discarded, threshold);
+    if (auto call = dynamic_cast<MemberFunctionCall*>(operand.get())) {
+        if (!dynamic_cast<VariableOp*>(call->operand.get()))
+            return nullptr;
+        return inline_call(callee_of(operand.get(), use), call->arguments, &call->operand, use,
+                           discarded, threshold);
+    }
+    return nullptr;
+}
+
+// inlines the calls of "entry", returns whether any was
+bool inline_calls(Scope* entry, int threshold) {
+    bool changed = false;
+
+    // the result of a call made as a statement is not used
+    for_each_block(entry, [&](Scope* block) {
+        for (auto& statement : block->statements) {
+            std::shared_ptr<Operand> inlined;
+            if (auto expression = dynamic_cast<Expression*>(statement.get())) {
+                if (expression->operands.size() == 1)
+                    inlined = inline_operand(expression->operands[0], *block, true, threshold);
+            } else if (auto call = dynamic_cast<FunctionCall*>(statement.get())) {
+                inlined = inline_call(block->find_function(call->function_name), call->arguments,
+                                      nullptr, *block, true, threshold);
+            }
+            if (inlined) {
+                auto expression = std::make_shared<Expression>();
+                expression->operands.push_back(inlined);
+                statement = expression;
+                changed = true;
+            }
+        }
+    });
+
+    for_each_expression(entry, [&](Expression& expression, Scope& use) {
+        for (auto& operand : expression.operands)
+            for_each_operand(operand, [&](std::shared_ptr<Operand>& op, bool written) {
+                // a call gives a temporary, writing to what replaces it would not be the same
+                if (written)
+                    return;
+                if (auto inlined = inline_operand(op, use, false, threshold)) {
+                    op = inlined;
+                    changed = true;
+                }
+            });
+    });
+    return changed;
+}
+
+}  // namespace
+
+void Inlining::run(std::shared_ptr<Scope> scope) {
+    if (threshold <= 0)
+        return;
+    for (int round = 0; round < depth; round++) {
+        std::vector<Scope*> entries = collect_entry_scopes(scope.get());
+        bool changed = false;
+        for (Scope* entry : entries)
+            changed |= inline_calls(entry, threshold);
+        if (!changed)
+            return;
+        // the inlined operators are specialized and their variables bound where they now are
+        for (Scope* entry : entries)
+            entry->resolve(*entry);
+    }
+}
+
+PassManager::PassManager() {
+    add(std::make_unique<Inlining>());
+    add(std::make_unique<ConstantFolding>());
+    add(std::make_unique<ConstantPropagation>());
+    add(std::make_unique<DeadCodeElimination>());
+    add(std::make_unique<LoopInvariantCodeMotion>());
+}
+
+void PassManager::add(std::unique_ptr<Pass> pass) {
+    passes.push_back({std::move(pass), true});
+}
+
+PassManager::Entry& PassManager::find(const std::string& name) {
+    for (auto& entry : passes)
+        if (entry.pass->name() == name)
+            return entry;
+    throw_exception("no optimization pass is named \"", name, '"');
+    return passes.front();
+}
+
+void PassManager::enable(const std::string& name, bool enabled) {
+    find(name).enabled = enabled;
+}
+
+bool PassManager::enabled(const std::string& name) const {
+    for (const auto& entry : passes)
+        if (entry.pass->name() == name)
+            return entry.enabled;
+    return false;
+}
+
+void PassManager::run(std::shared_ptr<Scope> scope) const {
+    for (const auto& entry : passes)
+        if (entry.enabled)
+            entry.pass->run(scope);
+}
+
+}  // namespace llc
@@ -12,7 +12,7 @@ void Parser::parse_recursively(std::shared_ptr<Scope> scope, bool end_after_stat
         }
 
         if (auto token = match(TokenType::Identifier)) {
-            if (auto type = scope->find_type(token->id) || token->id == "void") {
+            if (scope->find_type(token->id)) {
                 auto next0 = advance();
                 auto next1 = advance();
                 putback();
@@ -23,11 +23,11 @@ void Parser::parse_recursively(std::shared_ptr<Scope> scope, bool end_after_stat
                 else
                     declare_variable(scope);
 
-            } else if (auto var = scope->find_variable(token->id)) {
+            } else if (scope->find_variable(token->id)) {
                 putback();
                 scope->statements.push_back(std::make_shared<Expression>(build_expression(scope)));
 
-            } else if (auto function = scope->find_function(token->id)) {
+            } else if (scope->find_function(token->id)) {
                 putback();
                 scope->statements.push_back(std::make_shared<Expression>(build_expression(scope)));
 
@@ -96,7 +96,7 @@ void Parser::parse_recursively(std::shared_ptr<Scope> scope, bool end_after_stat
                 if (auto type_token = match(TokenType::Identifier)) {
                     auto type = must_has(for_scope->find_type(type_token->id), *type_token);
                     auto var_token = must_match(TokenType::Identifier);
-                    auto var = for_scope->variables[var_token.id] = *type;
+                    for_scope->add_variable(var_token.id, *type);
                 }
 
                 Expression initialization;
@@ -161,7 +161,7 @@ void Parser::declare_variable(std::shared_ptr<Scope> scope) {
         throw_exception("cannot declare variable of type \"void\"", type_token.location);
     auto type = must_has(scope->find_type(type_token.id), type_token);
     auto var_token = must_match(TokenType::Identifier);
-    auto var = scope->variables[var_token.id] = *type;
+    scope->add_variable(var_token.id, *type);
 
     if (match(TokenType::Assign)) {
         putback();
@@ -178,10 +178,11 @@ void Parser::declare_function(std::shared_ptr<Scope> scope) {
 
     func->return_type = *must_has(scope->find_type(return_type_token.id), return_type_token);
 
+    std::vector<Object> parameter_types;
     must_match(TokenType::LeftParenthese);
     while (!match(TokenType::RightParenthese)) {
         auto type_token = must_match(TokenType::Identifier);
-        must_has(scope->find_type(type_token.id), type_token);
+        parameter_types.push_back(*must_has(scope->find_type(type_token.id), type_token));
         auto var_token = must_match(TokenType::Identifier);
         func->parameters.push_back(var_token.id);
         if (must_match(TokenType::Comma | TokenType::RightParenthese).type ==
@@ -195,8 +196,9 @@ void Parser::declare_function(std::shared_ptr<Scope> scope) {
                             func_token.location(source));
         func->definition = std::make_shared<Scope>();
         func->definition->parent = scope;
-        for (auto param : func->parameters)
-            func->definition->variables.insert({param, Object()});
+        func->definition->function = true;
+        for (int i = 0; i < (int)func->parameters.size(); i++)
+            func->definition->add_variable(func->parameters[i], parameter_types[i]);
         parse_recursively(func->definition);
         must_match(TokenType::RightCurlyBracket);
     } else {
@@ -208,29 +210,30 @@ void Parser::declare_function(std::shared_ptr<Scope> scope) {
 
 void Parser::declare_struct(std::shared_ptr<Scope> scope) {
     auto type_name = must_match(TokenType::Identifier);
-    size_t type_id = type_id_to_name.size();
-    while (type_id_to_name.find(type_id) != type_id_to_name.end())
-        type_id++;
-    type_id_to_name[type_id] = type_name.id;
+    size_t type_id = new_type_id(type_name.id);
     must_match(TokenType::LeftCurlyBracket);
     auto definition = parse_recursively_topdown(scope);
     LLC_CHECK(definition != nullptr);
     must_match(TokenType::RightCurlyBracket);
-    auto object = std::make_unique<InternalObject>(type_id);
     definition->run(*scope);
 
-    for (auto& var : definition->variables)
-        object->members[var.first] = var.second;
-    for (auto& func : definition->functions)
-        object->functions[func.first] = func.second;
-
-    for (auto& func : object->functions) {
-        for (auto& var : object->members)
-            dynamic_cast<InternalFunction*>(func.second.base.get())->this_scope[var.first] =
-                &var.second;
+    // a field is at the offset of its slot in the struct body, methods are resolved against it
+    auto info = std::make_shared<StructInfo>();
+    info->fields.resize(definition->variables.size());
+    for (auto& var : definition->slots) {
+        info->fields[var.second] = var.first;
+        info->offsets[var.first] = var.second;
+    }
+    for (auto& func : definition->functions) {
+        auto function = dynamic_cast<InternalFunction*>(func.second.base.get());
+        if (function->definition)
+            function->definition->members = info->fields;
+        info->method_indices[func.first] = (int)info->methods.size();
+        info->methods.push_back(func.second);
     }
 
-    scope->types[type_name.id] = Object(std::move(object));
+    scope->types[type_name.id] =
+        Object(std::make_unique<InternalObject>(type_id, info, definition->variables));
 }
 
 Expression Parser::build_expression(std::shared_ptr<Scope> scope) {
@@ -381,7 +384,7 @@ Expression Parser::build_expression(std::shared_ptr<Scope> scope) {
             else if (scope->find_variable(token.id))
                 expression.operands.push_back(std::make_shared<VariableOp>(token.id));
 
-            else if (auto function = scope->find_function(token.id)) {
+            else if (scope->find_function(token.id)) {
                 expression.operands.push_back(
                     std::make_shared<FunctionCallOp>(build_functioncall(scope, token.id)));
             } else {
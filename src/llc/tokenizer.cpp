@@ -1,6 +1,8 @@
 #include <llc/tokenizer.h>
 
 #include <algorithm>
+#include <charconv>
+#include <limits>
 
 namespace llc {
 
@@ -204,11 +206,11 @@ std::vector<Token> Tokenizer::tokenize(const Program& program) {
                 token.id = scan_string(c);
                 if (token.id == "true") {
                     token.type = TokenType::Number;
-                    token.value = 1;
+                    token.value = Object(true);
                 }
                 if (token.id == "false") {
                     token.type = TokenType::Number;
-                    token.value = 0;
+                    token.value = Object(false);
                 }
             }
             break;
@@ -229,27 +231,44 @@ std::vector<Token> Tokenizer::tokenize(const Program& program) {
     return tokens;
 }
 
-float Tokenizer::scan_value(char c) {
-    float number = 0.0f;
+Object Tokenizer::scan_value(char c) {
+    std::string text;
     do {
-        number = number * 10.0f + c - '0';
+        text += c;
         c = next();
     } while (is_digit(c));
 
-    if (c == '.') {
-        c = next();
-
-        float scale = 0.1f;
-        while (is_digit(c)) {
-            number += (c - '0') * scale;
-            scale /= 10.0f;
+    bool real = c == '.';
+    if (real) {
+        do {
+            text += c;
             c = next();
-        };
+        } while (is_digit(c));
+    }
+
+    const char* first = text.data();
+    const char* last = text.data() + text.size();
+    if (c == 'f') {
+        float value = 0.0f;
+        std::from_chars(first, last, value);
+        return Object(value);
     }
-    if (c != 'f')
+    if (real) {
         putback();
+        double value = 0.0;
+        std::from_chars(first, last, value);
+        return Object(value);
+    }
 
-    return number;
+    bool long_suffix = c == 'l';
+    if (!long_suffix)
+        putback();
+    int64_t value = 0;
+    if (std::from_chars(first, last, value).ec == std::errc::result_out_of_range)
+        throw_exception("integer literal \"", text, "\" is too large");
+    if (!long_suffix && value <= std::numeric_limits<int>::max())
+        return Object(int(value));
+    return Object(value);
 }
 
 std::string Tokenizer::scan_string(char c) {
@@ -1,19 +1,63 @@
 #include <llc/types.h>
 
 #include <algorithm>
+#include <mutex>
+#include <set>
 
 namespace llc {
 
-std::unordered_map<size_t, std::string> type_id_to_name = {
-    {typeid(void).hash_code(), "void"},           {typeid(int).hash_code(), "int"},
-    {typeid(char).hash_code(), "char"},          {typeid(uint8_t).hash_code(), "uint8_t"},
-    {typeid(uint16_t).hash_code(), "uint16_t"},  {typeid(uint32_t).hash_code(), "uint32_t"},
-    {typeid(uint64_t).hash_code(), "uint64_t"},  {typeid(int8_t).hash_code(), "int8_t"},
-    {typeid(int16_t).hash_code(), "int16_t"},    {typeid(int64_t).hash_code(), "int64_t"},
-    {typeid(float).hash_code(), "float"},        {typeid(double).hash_code(), "double"},
-    {typeid(std::string).hash_code(), "string"}, {typeid(bool).hash_code(), "bool"},
+namespace {
+
+// names of types by id, ids are handed out from any thread the first time a type is used
+struct TypeNames {
+    std::mutex mutex;
+    std::vector<std::string> names = std::vector<std::string>(num_arithmetic_types);
 };
 
+TypeNames& type_names() {
+    static TypeNames type_names;
+    return type_names;
+}
+
+const bool builtin_type_names = [] {
+    set_type_name<void>("void");
+    set_type_name<bool>("bool");
+    set_type_name<char>("char");
+    set_type_name<int>("int");
+    set_type_name<float>("float");
+    set_type_name<double>("double");
+    set_type_name<int8_t>("int8_t");
+    set_type_name<int16_t>("int16_t");
+    set_type_name<int64_t>("int64_t");
+    set_type_name<uint8_t>("uint8_t");
+    set_type_name<uint16_t>("uint16_t");
+    set_type_name<uint32_t>("uint32_t");
+    set_type_name<uint64_t>("uint64_t");
+    set_type_name<std::string>("string");
+    return true;
+}();
+
+}  // namespace
+
+size_t new_type_id(std::string name) {
+    std::lock_guard<std::mutex> lock(type_names().mutex);
+    type_names().names.push_back(name);
+    return type_names().names.size() - 1;
+}
+
+void set_type_name(size_t type_id, std::string name) {
+    std::lock_guard<std::mutex> lock(type_names().mutex);
+    LLC_CHECK(type_id < type_names().names.size());
+    type_names().names[type_id] = name;
+}
+
+std::string find_type_name(size_t type_id) {
+    std::lock_guard<std::mutex> lock(type_names().mutex);
+    if (type_id >= type_names().names.size())
+        return "";
+    return type_names().names[type_id];
+}
+
 std::string Location::operator()(const std::string& source) const {
     LLC_CHECK(line >= 0);
     LLC_CHECK(column >= 0);
@@ -50,153 +94,509 @@ std::string enum_to_string(TokenType type) {
     return str;
 }
 
+std::optional<Object> BaseFunction::run_method(const Scope& scope,
+                                               const std::vector<Expression>& exprs,
+                                               BaseObject*) const {
+    return run(scope, exprs);
+}
+
 Object& BaseObject::get_member(const std::string& name) {
-    if (members.find(name) == members.end())
+    int index = member_index(name);
+    if (index < 0)
         throw_exception("cannot find member \"", name, '"');
-    return members[name];
-}
-
-Scope::Scope() {
-    types["void"] = Object();
-    types["int"] = Object(int(0));
-    types["char"] = Object(char(0));
-    types["uint8_t"] = Object(uint8_t(0));
-    types["uint16_t"] = Object(uint16_t(0));
-    types["uint32_t"] = Object(uint32_t(0));
-    types["uint64_t"] = Object(uint64_t(0));
-    types["int8_t"] = Object(int8_t(0));
-    types["int16_t"] = Object(int16_t(0));
-    types["int64_t"] = Object(int64_t(0));
-    types["float"] = Object(0.0f);
-    types["double"] = Object(0.0);
-    types["bool"] = Object(false);
-}
-std::optional<Object> Scope::run(const Scope&) const {
+    return member_at(index);
+}
+
+Object& BaseObject::member_at(int) {
+    throw_exception("type \"", type_name(), "\" has no such member");
+    static Object null_object;
+    return null_object;
+}
+
+const Function& BaseObject::method_at(int) const {
+    throw_exception("type \"", type_name(), "\" has no such function");
+    static Function null_function;
+    return null_function;
+}
+
+Function* BaseObject::find_function(const std::string& name) {
+    auto it = functions.find(name);
+    return it == functions.end() ? nullptr : &it->second;
+}
+
+const std::unordered_map<std::string, Object>& builtin_types() {
+    static const std::unordered_map<std::string, Object> types = {
+        {"void", Object()},
+        {"int", Object(int(0))},
+        {"char", Object(char(0))},
+        {"uint8_t", Object(uint8_t(0))},
+        {"uint16_t", Object(uint16_t(0))},
+        {"uint32_t", Object(uint32_t(0))},
+        {"uint64_t", Object(uint64_t(0))},
+        {"int8_t", Object(int8_t(0))},
+        {"int16_t", Object(int16_t(0))},
+        {"int64_t", Object(int64_t(0))},
+        {"float", Object(0.0f)},
+        {"double", Object(0.0)},
+        {"bool", Object(false)},
+    };
+    return types;
+}
+
+Completion Scope::run(const Scope&) const {
+    if (compiled)
+        return compiled->run(*this);
+
     for (const auto& statement : statements)
         LLC_CHECK(statement != nullptr);
 
     for (const auto& statement : statements) {
-        statement->run(*this);
+        Completion completion = statement->run(*this);
+        if (completion.flow != Flow::Normal)
+            return completion;
     }
 
-    return std::nullopt;
+    return {};
 }
-std::optional<Object> Scope::find_type(const std::string& name) const {
-    auto it = types.find(name);
-    if (it == types.end())
-        return parent ? parent->find_type(name) : std::nullopt;
-    else
-        return it->second;
+const Object* Scope::find_type(const std::string& name) const {
+    for (const Scope* scope = this; scope != nullptr; scope = scope->parent.get()) {
+        auto it = scope->types.find(name);
+        if (it != scope->types.end())
+            return &it->second;
+    }
+    auto builtin = builtin_types().find(name);
+    return builtin != builtin_types().end() ? &builtin->second : nullptr;
 }
-std::optional<Object> Scope::find_variable(const std::string& name) const {
-    auto it = variables.find(name);
-    if (it == variables.end())
-        return parent ? parent->find_variable(name) : std::nullopt;
-    else
-        return it->second;
+Object* Scope::find_variable(const std::string& name) const {
+    for (const Scope* scope = this; scope != nullptr; scope = scope->parent.get()) {
+        auto it = scope->slots.find(name);
+        if (it != scope->slots.end())
+            return &scope->variables[it->second];
+    }
+    return nullptr;
 }
-std::optional<Function> Scope::find_function(const std::string& name) const {
-    auto it = functions.find(name);
-    if (it == functions.end())
-        return parent ? parent->find_function(name) : std::nullopt;
-    else
-        return it->second;
+const Function* Scope::find_function(const std::string& name) const {
+    for (const Scope* scope = this; scope != nullptr; scope = scope->parent.get()) {
+        auto it = scope->functions.find(name);
+        if (it != scope->functions.end())
+            return &it->second;
+    }
+    return nullptr;
 }
 Object& Scope::get_variable(const std::string& name) const {
-    auto it = variables.find(name);
-    if (it == variables.end()) {
-        if (!parent)
-            throw_exception("cannot get varaible \"", name, '"');
-        return parent->get_variable(name);
-    } else
+    if (Object* object = find_variable(name))
+        return *object;
+    throw_exception("cannot get varaible \"", name, '"');
+    static Object null_object;
+    return null_object;
+}
+
+int Scope::add_variable(const std::string& name, const Object& object) {
+    auto it = slots.find(name);
+    if (it != slots.end()) {
+        variables[it->second] = object;
         return it->second;
+    }
+    variables.push_back(object);
+    return slots[name] = (int)variables.size() - 1;
 }
 
-BaseObject* InternalObject::clone() const {
-    InternalObject* object = new InternalObject(*this);
-    for (auto& func : object->functions) {
-        for (auto& var : object->members)
-            dynamic_cast<InternalFunction*>(func.second.base.get())->this_scope[var.first] =
-                &var.second;
+void Scope::resolve(const Scope&) {
+    for (const auto& statement : statements)
+        statement->resolve(*this);
+}
+
+void Scope::allocate_frame() {
+    frame.clear();
+    for_each_block(this, [&](Scope* block) {
+        block->frame_offset = (int)frame.size();
+        frame.insert(frame.end(), block->variables.begin(), block->variables.end());
+    });
+}
+
+void for_each_block(Scope* scope, const std::function<void(Scope*)>& visit) {
+    if (scope == nullptr)
+        return;
+    visit(scope);
+    for (const auto& statement : scope->statements) {
+        if (auto chain = dynamic_cast<IfElseChain*>(statement.get())) {
+            for (const auto& body : chain->bodys)
+                for_each_block(body.get(), visit);
+        } else if (auto loop = dynamic_cast<For*>(statement.get())) {
+            for_each_block(loop->internal_scope.get(), visit);
+            for_each_block(loop->body.get(), visit);
+        } else if (auto loop = dynamic_cast<While*>(statement.get())) {
+            for_each_block(loop->body.get(), visit);
+        } else if (auto block = dynamic_cast<Scope*>(statement.get())) {
+            for_each_block(block, visit);
+        }
+    }
+}
+
+static void collect_entry_scopes(Scope* scope, std::set<Scope*>& visited,
+                                 std::vector<Scope*>& entries);
+
+static void collect_entry_scopes(const Function& function, std::set<Scope*>& visited,
+                                 std::vector<Scope*>& entries) {
+    auto internal = dynamic_cast<InternalFunction*>(function.base.get());
+    if (internal == nullptr || internal->definition == nullptr)
+        return;
+    if (!visited.count(internal->definition.get()))
+        entries.push_back(internal->definition.get());
+    collect_entry_scopes(internal->definition.get(), visited, entries);
+}
+
+static void collect_entry_scopes(Scope* scope, std::set<Scope*>& visited,
+                                 std::vector<Scope*>& entries) {
+    if (scope == nullptr || !visited.insert(scope).second)
+        return;
+
+    for (const auto& function : scope->functions)
+        collect_entry_scopes(function.second, visited, entries);
+    for (const auto& type : scope->types)
+        if (auto object = dynamic_cast<InternalObject*>(type.second.base.get()))
+            for (const auto& function : object->info->methods)
+                collect_entry_scopes(function, visited, entries);
+
+    for (const auto& statement : scope->statements) {
+        if (auto chain = dynamic_cast<IfElseChain*>(statement.get())) {
+            for (const auto& body : chain->bodys)
+                collect_entry_scopes(body.get(), visited, entries);
+        } else if (auto loop = dynamic_cast<For*>(statement.get())) {
+            collect_entry_scopes(loop->internal_scope.get(), visited, entries);
+            collect_entry_scopes(loop->body.get(), visited, entries);
+        } else if (auto loop = dynamic_cast<While*>(statement.get())) {
+            collect_entry_scopes(loop->body.get(), visited, entries);
+        } else if (auto block = dynamic_cast<Scope*>(statement.get())) {
+            collect_entry_scopes(block, visited, entries);
+        }
     }
+}
 
-    return object;
+std::vector<Scope*> collect_entry_scopes(Scope* scope) {
+    std::set<Scope*> visited;
+    std::vector<Scope*> entries = {scope};
+    collect_entry_scopes(scope, visited, entries);
+    return entries;
 }
 
 std::optional<Object> InternalFunction::run(const Scope& scope,
                                             const std::vector<Expression>& exprs) const {
-    LLC_CHECK(parameters.size() == exprs.size());
-    LLC_CHECK(definition != nullptr);
+    return run_method(scope, exprs, nullptr);
+}
 
-    for (int i = 0; i < (int)exprs.size(); i++)
-        LLC_CHECK(definition->variables.find(parameters[i]) != definition->variables.end());
+std::optional<Object> InternalFunction::run_method(const Scope& scope,
+                                                   const std::vector<Expression>& exprs,
+                                                   BaseObject* self) const {
+    ScratchVector<Object> args;
+    for (const auto& expr : exprs)
+        if (auto result = expr(scope))
+            args.values.push_back(std::move(*result));
+        else
+            throw_exception("void cannot be used as function parameter");
 
-    std::map<std::string, Object> temp;
+    return call(scope, args.values, dynamic_cast<InternalObject*>(self));
+}
 
-    for (int i = 0; i < (int)exprs.size(); i++)
-        if (auto result = exprs[i](scope)) {
-            temp[parameters[i]] = *result;
-        } else
-            throw_exception("void cannot be used as function parameter");
+namespace {
+
+// makes a frame current for the duration of a call, frames are recycled per thread so that their
+// objects usually only need to be reset
+thread_local std::vector<std::unique_ptr<Frame>> frame_pool;
 
-    for (const auto& var : temp)
-        definition->variables[var.first] = var.second;
+struct Activation {
+    Activation() : previous(Frame::current) {
+        if (frame_pool.empty()) {
+            frame = std::make_unique<Frame>();
+        } else {
+            frame = std::move(frame_pool.back());
+            frame_pool.pop_back();
+        }
+        Frame::current = frame.get();
+    }
+    ~Activation() {
+        Frame::current = previous;
+        frame_pool.push_back(std::move(frame));
+    }
+
+    std::unique_ptr<Frame> frame;
+    Frame* previous;
+};
 
-    for (const auto& var : this_scope)
-        definition->variables[var.first] = *var.second;
+}  // namespace
 
+static bool same_type(const Object& a, const Object& b) {
+    if (a.is_void() || b.is_void())
+        return a.is_void() == b.is_void();
+    return a.type_id() == b.type_id();
+}
+
+std::optional<Object> InternalFunction::call(const Scope& scope, const std::vector<Object>& args,
+                                             InternalObject* self) const {
+    if (native)
+        return native->call(args);
+
+    // every call runs on its own frame so that recursive calls and calls from several threads do
+    // not share locals
+    Activation activation;
+    Frame& frame = *activation.frame;
+    enter(frame, args, activation.previous, self);
+
+    // "return f(...)" leaves the call of "f" in the frame, which then runs in place of the
+    // current one, so tail recursion takes constant space. when the return types differ the
+    // result needs another conversion and the callee is called as usual instead
+    const InternalFunction* function = this;
+    ScratchVector<Object> arguments;
     std::optional<Object> result;
-    try {
-        result = definition->run(scope);
-    } catch (const std::optional<Object>& ret) {
-        result = ret;
+    while (true) {
+        Completion completion = function->definition->run(scope);
+        if (completion.flow == Flow::TailCall) {
+            const InternalFunction* callee = frame.tail_function;
+            arguments.values.swap(frame.tail_arguments);
+            if (!same_type(callee->return_type, function->return_type)) {
+                result = callee->call(scope, arguments.values);
+                break;
+            }
+            function = callee;
+            function->enter(frame, arguments.values, &frame);
+            continue;
+        }
+
+        // a break outside of any loop ends the function like a return without value
+        if (completion.flow == Flow::Return)
+            result = std::move(completion.value);
+        break;
     }
 
-    for (auto& var : this_scope)
-        *var.second = definition->variables[var.first];
+    if (result && !result->is_void() && !function->return_type.is_void() &&
+        !same_type(*result, function->return_type)) {
+        Object converted = function->return_type;
+        converted.assign(*result);
+        result = std::move(converted);
+    }
 
     return result;
 }
 
-std::optional<Object> ExternalFunction::run(const Scope& scope,
-                                            const std::vector<Expression>& exprs) const {
-    std::vector<Object> arguments;
+// parameters are the first locals of the frame, arguments are converted to their types and the
+// other locals start from their declared value. a method runs on "self", or on the object of
+// "caller" when it is called by name from another method of the same struct
+void InternalFunction::enter(Frame& frame, const std::vector<Object>& args, const Frame* caller,
+                             InternalObject* self) const {
+    LLC_CHECK(parameters.size() == args.size());
+    LLC_CHECK(definition != nullptr);
+
+    const std::vector<Object>& prototype = definition->frame;
+    std::vector<Object>& locals = frame.locals;
+    LLC_CHECK(prototype.size() >= args.size());
+    locals.resize(prototype.size());
+    for (size_t i = 0; i < prototype.size(); i++) {
+        if (!same_type(locals[i], prototype[i]) || locals[i].is_void())
+            locals[i] = prototype[i];
+        else if (i >= args.size())
+            locals[i].assign(prototype[i]);
+    }
+    for (size_t i = 0; i < args.size(); i++)
+        locals[i].assign(args[i]);
+
+    if (definition->members.empty())
+        frame.self = nullptr;
+    else if (self != nullptr)
+        frame.self = self;
+    else if (caller != nullptr && caller->self != nullptr &&
+             caller->self->fields.size() == definition->members.size())
+        frame.self = caller->self;
+    else
+        throw_exception("member function called without an object");
+}
+
+void ExternalFunction::arguments(std::vector<Object>& arguments, const Scope& scope,
+                                 const std::vector<Expression>& exprs) {
     for (auto& expr : exprs) {
         if (auto result = expr(scope))
-            arguments.push_back(*result);
+            arguments.push_back(std::move(*result));
         else
             throw_exception("void cannot be passes as argument to function");
     }
-    return invoke(arguments);
+}
+
+std::optional<Object> ExternalFunction::run(const Scope& scope,
+                                            const std::vector<Expression>& exprs) const {
+    ScratchVector<Object> args;
+    arguments(args.values, scope, exprs);
+    return invoke(args.values);
+}
+
+Object& MemberAccess::member_of(Object& object) const {
+    if (object.base == nullptr)
+        throw_exception("cannot find member \"", member_name, '"');
+    BaseObject& base = *object.base;
+    int index = cache.find(base.type_id());
+    if (index < 0) {
+        index = base.member_index(member_name);
+        if (index < 0)
+            throw_exception("cannot find member \"", member_name, '"');
+        cache.store(base.type_id(), index);
+    }
+    return base.member_at(index);
 }
 
 Object MemberFunctionCall::evaluate(const Scope& scope) const {
-    if (operand->original(scope).base->functions.find(function_name) ==
-        operand->original(scope).base->functions.end())
+    Object& object = operand->original(scope);
+    if (object.base == nullptr)
         throw_exception("cannot find function \"", function_name, '"');
+    BaseObject& base = *object.base;
+    int index = cache.find(base.type_id());
+    if (index < 0) {
+        index = base.method_index(function_name);
+        if (index < 0)
+            throw_exception("cannot find function \"", function_name, '"');
+        cache.store(base.type_id(), index);
+    }
 
-    if (auto result =
-            operand->original(scope).base->functions[function_name].run(scope, arguments)) {
-        return *result;
+    if (auto result = base.method_at(index).run_method(scope, arguments, &base)) {
+        return std::move(*result);
     } else {
         return {};
     }
 }
 
+void MemberFunctionCall::resolve(const Scope& scope) {
+    PostUnaryOp::resolve(scope);
+    for (auto& argument : arguments)
+        argument.resolve(scope);
+}
+
 Object TypeOp::evaluate(const Scope& scope) const {
-    std::vector<Object> args;
+    ScratchVector<Object> args;
     for (const auto& arg : arguments) {
         if (auto v = arg(scope))
-            args.push_back(*v);
+            args.values.push_back(std::move(*v));
         else
             throw_exception("argument to constructor must-not be \"void\"");
     }
-    if (args.size())
-        return Object::construct(type, args);
+    if (args.values.size())
+        return Object::construct(type, args.values);
     else
         return type;
 }
 
+void TypeOp::resolve(const Scope& scope) {
+    for (auto& argument : arguments)
+        argument.resolve(scope);
+}
+
+void VariableOp::resolve(const Scope& scope) {
+    // variables of the enclosing function live in the frame of the call, beyond it they are
+    // members of the object of a method or fixed
+    ref = {};
+    type = typeid_unknown;
+    bool outside = false;
+    for (const Scope* current = &scope; current; current = current->parent.get()) {
+        auto it = current->slots.find(name);
+        if (it != current->slots.end()) {
+            if (!outside && current->frame_offset >= 0)
+                ref.local = current->frame_offset + it->second;
+            else
+                ref.object = &current->variables[it->second];
+            const Object& variable = current->variables[it->second];
+            if (!variable.is_void())
+                type = variable.type_id();
+            return;
+        }
+        if (current->function && !outside) {
+            auto member = std::find(current->members.begin(), current->members.end(), name);
+            if (member != current->members.end()) {
+                ref.member = int(member - current->members.begin());
+                return;
+            }
+            outside = true;
+        }
+    }
+}
+
+namespace {
+
+template <template <typename, typename, typename> typename Specialization, typename Node,
+          typename T>
+std::shared_ptr<Operand> specialize(const Node& node, size_t rhs) {
+    if (rhs == typeid_int)
+        return std::make_shared<Specialization<Node, T, int>>(node);
+    if (rhs == typeid_float)
+        return std::make_shared<Specialization<Node, T, float>>(node);
+    if (rhs == typeid_double)
+        return std::make_shared<Specialization<Node, T, double>>(node);
+    return nullptr;
+}
+
+template <template <typename, typename, typename> typename Specialization, typename Node>
+std::shared_ptr<Operand> specialize(const Node& node) {
+    size_t lhs = node.a->static_type(), rhs = node.b->static_type();
+    if (lhs == typeid_int)
+        return specialize<Specialization, Node, int>(node, rhs);
+    if (lhs == typeid_float)
+        return specialize<Specialization, Node, float>(node, rhs);
+    if (lhs == typeid_double)
+        return specialize<Specialization, Node, double>(node, rhs);
+    return nullptr;
+}
+
+template <typename Node>
+std::shared_ptr<Operand> specialize(const Operand& operand) {
+    if (typeid(operand) != typeid(Node))
+        return nullptr;
+    return specialize<Specialized>(static_cast<const Node&>(operand));
+}
+
+// compound assignments and increments are only updated in place when they target a variable,
+// other places such as the members of host objects may not be plain values
+template <typename Node>
+std::shared_ptr<Operand> specialize_assignment(const Operand& operand) {
+    if (typeid(operand) != typeid(Node))
+        return nullptr;
+    const Node& node = static_cast<const Node&>(operand);
+    if (dynamic_cast<const VariableOp*>(node.a.get()) == nullptr)
+        return nullptr;
+    return specialize<SpecializedAssignment>(node);
+}
+
+template <typename Node>
+std::shared_ptr<Operand> specialize_update(const Operand& operand) {
+    if (typeid(operand) != typeid(Node))
+        return nullptr;
+    const Node& node = static_cast<const Node&>(operand);
+    if (dynamic_cast<const VariableOp*>(node.operand.get()) == nullptr)
+        return nullptr;
+    size_t type = node.operand->static_type();
+    if (type == typeid_int)
+        return std::make_shared<SpecializedUpdate<Node, int>>(node);
+    if (type == typeid_float)
+        return std::make_shared<SpecializedUpdate<Node, float>>(node);
+    if (type == typeid_double)
+        return std::make_shared<SpecializedUpdate<Node, double>>(node);
+    return nullptr;
+}
+
+}  // namespace
+
+std::shared_ptr<Operand> specialize(const std::shared_ptr<Operand>& operand) {
+    using Specializer = std::shared_ptr<Operand> (*)(const Operand&);
+    static const Specializer specializers[] = {
+        specialize<Addition>,         specialize<Subtrbody>,
+        specialize<Multiplication>,   specialize<Division>,
+        specialize<LessThan>,         specialize<LessEqual>,
+        specialize<GreaterThan>,      specialize<GreaterEqual>,
+        specialize<Equal>,            specialize<NotEqual>,
+        specialize_assignment<AddEqual>, specialize_assignment<SubtractEqual>,
+        specialize_assignment<MultiplyEqual>, specialize_assignment<DivideEqual>,
+        specialize_update<PreIncrement>, specialize_update<PreDecrement>,
+        specialize_update<PostIncrement>, specialize_update<PostDecrement>};
+    for (Specializer specializer : specializers)
+        if (auto specialized = specializer(*operand))
+            return specialized;
+    return operand;
+}
+
 void Expression::apply_parenthese() {
     int highest_prec = 0;
     for (const auto& operand : operands)
@@ -247,53 +647,203 @@ void Expression::collapse() {
     }
 }
 
-std::optional<Object> IfElseChain::run(const Scope& scope) const {
+Completion IfElseChain::run(const Scope& scope) const {
     LLC_CHECK(conditions.size() == bodys.size() || conditions.size() == bodys.size() - 1);
     for (int i = 0; i < (int)bodys.size(); i++)
         LLC_CHECK(bodys[i] != nullptr);
 
-    for (int i = 0; i < (int)conditions.size(); i++) {
-        try {
-            if (conditions[i](scope)->as<bool>())
-                bodys[i]->run(scope);
-        } catch (const std::optional<Object>& object) {
-            throw object;
-        }
-    }
+    for (int i = 0; i < (int)conditions.size(); i++)
+        if (conditions[i](scope)->as<bool>())
+            return bodys[i]->run(scope);
 
-    if (conditions.size() == bodys.size() - 1) {
-        bodys.back()->run(scope);
-    }
+    if (conditions.size() == bodys.size() - 1)
+        return bodys.back()->run(scope);
 
-    return std::nullopt;
+    return {};
 }
 
-std::optional<Object> For::run(const Scope& scope) const {
+void IfElseChain::resolve(const Scope& scope) {
+    for (auto& condition : conditions)
+        condition.resolve(scope);
+    for (const auto& body : bodys)
+        body->resolve(*body);
+}
+
+Completion For::run(const Scope& scope) const {
     LLC_CHECK(body != nullptr);
 
-    for (initialization(*internal_scope); condition(*internal_scope)->as<bool>();
-         updation(*internal_scope)->as<bool>()) {
-        try {
-            body->run(scope);
-        } catch (const BreakLoop&) {
-            return std::nullopt;
+    Completion result;
+    initialization(*internal_scope);
+    iterate([&] {
+        Completion completion = body->run(scope);
+        if (completion.flow == Flow::Normal)
+            return true;
+        if (completion.flow != Flow::Break)
+            result = std::move(completion);
+        return false;
+    });
+
+    return result;
+}
+
+const InternalFunction* tail_callee(const Function* function) {
+    if (function == nullptr)
+        return nullptr;
+    auto internal = dynamic_cast<const InternalFunction*>(function->base.get());
+    if (internal == nullptr || internal->native || internal->definition == nullptr)
+        return nullptr;
+    return internal;
+}
+
+Completion Return::run(const Scope& scope) const {
+    if (tail_call)
+        if (auto callee = tail_callee(scope.find_function(tail_call->function_name))) {
+            Frame& frame = *Frame::current;
+            frame.tail_arguments.resize(tail_call->arguments.size());
+            for (size_t i = 0; i < tail_call->arguments.size(); i++) {
+                auto argument = tail_call->arguments[i](scope);
+                if (!argument)
+                    throw_exception("void cannot be used as function parameter");
+                frame.tail_arguments[i] = std::move(*argument);
+            }
+            frame.tail_function = callee;
+            return {Flow::TailCall};
         }
+
+    return {Flow::Return, expression(scope)};
+}
+
+void Return::resolve(const Scope& scope) {
+    expression.resolve(scope);
+
+    tail_call = nullptr;
+    const Scope* function = &scope;
+    while (function && !function->function)
+        function = function->parent.get();
+    if (function && expression.operands.size() == 1)
+        if (auto call = dynamic_cast<FunctionCallOp*>(expression.operands[0].get()))
+            tail_call = &call->function;
+}
+
+namespace {
+
+// the counter of "++i", "i--", "i += k" and "i -= k" and how much it is stepped by, "k" being an
+// integer literal
+std::optional<std::pair<const VariableOp*, int64_t>> step_of(const Operand& operand) {
+    auto counter = [](const std::shared_ptr<Operand>& operand) {
+        return dynamic_cast<const VariableOp*>(operand.get());
+    };
+    auto literal = [](const std::shared_ptr<Operand>& operand) -> std::optional<int64_t> {
+        auto number = dynamic_cast<const NumberLiteral*>(operand.get());
+        if (number == nullptr || (number->value.kind != Object::Kind::Int &&
+                                  number->value.kind != Object::Kind::Int64))
+            return std::nullopt;
+        return number->value.as<int64_t>();
+    };
+
+    const VariableOp* variable = nullptr;
+    std::optional<int64_t> step;
+    if (dynamic_cast<const PreIncrement*>(&operand) ||
+        dynamic_cast<const PreDecrement*>(&operand)) {
+        variable = counter(static_cast<const PreUnaryOp&>(operand).operand);
+        step = dynamic_cast<const PreIncrement*>(&operand) ? 1 : -1;
+    } else if (dynamic_cast<const PostIncrement*>(&operand) ||
+               dynamic_cast<const PostDecrement*>(&operand)) {
+        variable = counter(static_cast<const PostUnaryOp&>(operand).operand);
+        step = dynamic_cast<const PostIncrement*>(&operand) ? 1 : -1;
+    } else if (auto add = dynamic_cast<const AddEqual*>(&operand)) {
+        variable = counter(add->a);
+        step = literal(add->b);
+    } else if (auto sub = dynamic_cast<const SubtractEqual*>(&operand)) {
+        variable = counter(sub->a);
+        if ((step = literal(sub->b)))
+            step = -*step;
     }
+    if (variable == nullptr || !step)
+        return std::nullopt;
+    return std::pair{variable, *step};
+}
 
-    return std::nullopt;
+std::optional<CountedLoop> counted_loop(const Expression& condition,
+                                        const Expression& updation) {
+    if (condition.operands.size() != 1 || updation.operands.size() != 1)
+        return std::nullopt;
+    auto step = step_of(*updation.operands[0]);
+    if (!step || !step->first->ref)
+        return std::nullopt;
+
+    CountedLoop loop;
+    loop.counter = step->first->ref;
+    loop.step = step->second;
+    size_t type = step->first->static_type();
+    if (type == typeid_int)
+        loop.kind = Object::Kind::Int;
+    else if (type == typeid_int64)
+        loop.kind = Object::Kind::Int64;
+    else
+        return std::nullopt;
+
+    Operand* operand = condition.operands[0].get();
+    if (dynamic_cast<LessThan*>(operand))
+        loop.compare = CountedLoop::Compare::LessThan;
+    else if (dynamic_cast<LessEqual*>(operand))
+        loop.compare = CountedLoop::Compare::LessEqual;
+    else if (dynamic_cast<GreaterThan*>(operand))
+        loop.compare = CountedLoop::Compare::GreaterThan;
+    else if (dynamic_cast<GreaterEqual*>(operand))
+        loop.compare = CountedLoop::Compare::GreaterEqual;
+    else if (dynamic_cast<NotEqual*>(operand))
+        loop.compare = CountedLoop::Compare::NotEqual;
+    else
+        return std::nullopt;
+
+    auto comparison = static_cast<BinaryOp*>(operand);
+    auto counter = dynamic_cast<const VariableOp*>(comparison->a.get());
+    if (counter == nullptr || !(counter->ref == loop.counter))
+        return std::nullopt;
+    if (auto number = dynamic_cast<const NumberLiteral*>(comparison->b.get())) {
+        if (number->value.kind != Object::Kind::Int && number->value.kind != Object::Kind::Int64)
+            return std::nullopt;
+        loop.constant = std::make_shared<Object>(
+            type == typeid_int ? Object(number->value.as<int>())
+                               : Object(number->value.as<int64_t>()));
+        loop.limit.object = loop.constant.get();
+    } else if (auto limit = dynamic_cast<const VariableOp*>(comparison->b.get())) {
+        if (!limit->ref || limit->static_type() != type)
+            return std::nullopt;
+        loop.limit = limit->ref;
+    } else {
+        return std::nullopt;
+    }
+    return loop;
+}
+
+}  // namespace
+
+void For::resolve(const Scope&) {
+    initialization.resolve(*internal_scope);
+    condition.resolve(*internal_scope);
+    updation.resolve(*internal_scope);
+    body->resolve(*body);
+    counted = counted_loop(condition, updation);
 }
 
-std::optional<Object> While::run(const Scope& scope) const {
+Completion While::run(const Scope& scope) const {
     LLC_CHECK(body != nullptr);
 
     while (condition(scope)->as<bool>()) {
-        try {
-            body->run(scope);
-        } catch (const BreakLoop&) {
-            return std::nullopt;
-        }
+        Completion completion = body->run(scope);
+        if (completion.flow == Flow::Break)
+            break;
+        if (completion.flow != Flow::Normal)
+            return completion;
     }
-    return std::nullopt;
+    return {};
+}
+
+void While::resolve(const Scope& scope) {
+    condition.resolve(scope);
+    body->resolve(*body);
 }
 
 }  // namespace llc
\ No newline at end of file
@@ -0,0 +1,478 @@
+#include <llc/vm.h>
+
+#include <algorithm>
+
+namespace llc {
+
+void BytecodeCompiler::compile(std::shared_ptr<Scope> scope) {
+    std::vector<Scope*> definitions = collect_entry_scopes(scope.get());
+
+    std::vector<std::shared_ptr<Bytecode>> compiled;
+    for (Scope* definition : definitions)
+        compiled.push_back(compile_scope(*definition));
+
+    // install only after every body is lowered, so that lowering never observes a
+    // half-compiled program
+    for (size_t i = 0; i < definitions.size(); i++)
+        definitions[i]->compiled = compiled[i];
+}
+
+std::shared_ptr<Bytecode> BytecodeCompiler::compile_scope(const Scope& scope) {
+    auto bytecode = std::make_shared<Bytecode>();
+    chunk = &bytecode->chunk;
+    depth = 0;
+    breaks.clear();
+
+    emit_scope(scope);
+    emit(OpCode::ReturnVoid);
+
+    chunk = nullptr;
+    return bytecode;
+}
+
+void BytecodeCompiler::emit_scope(const Scope& scope) {
+    for (const auto& statement : scope.statements)
+        emit_statement(statement, scope);
+}
+
+void BytecodeCompiler::emit_statement(const std::shared_ptr<Statement>& statement,
+                                      const Scope& scope) {
+    LLC_CHECK(statement != nullptr);
+
+    if (auto expression = dynamic_cast<Expression*>(statement.get())) {
+        emit_expression(*expression, scope, true);
+
+    } else if (auto ret = dynamic_cast<Return*>(statement.get())) {
+        const Function* callee =
+            ret->tail_call ? scope.find_function(ret->tail_call->function_name) : nullptr;
+        if (tail_callee(callee)) {
+            for (const auto& argument : ret->tail_call->arguments)
+                emit_expression(argument, scope, false);
+            emit(OpCode::TailCall, add_function(callee, scope),
+                 (int)ret->tail_call->arguments.size());
+        } else if (ret->expression.operands.size()) {
+            emit_expression(ret->expression, scope, false);
+            emit(OpCode::Return);
+        } else {
+            emit(OpCode::ReturnVoid);
+        }
+
+    } else if (dynamic_cast<Break*>(statement.get()) && breaks.size()) {
+        breaks.back().push_back(emit(OpCode::Jump));
+
+    } else if (auto chain = dynamic_cast<IfElseChain*>(statement.get())) {
+        std::vector<int> ends;
+        for (size_t i = 0; i < chain->conditions.size(); i++) {
+            emit_expression(chain->conditions[i], scope, false);
+            int next = emit(OpCode::JumpIfFalse);
+            emit_scope(*chain->bodys[i]);
+            ends.push_back(emit(OpCode::Jump));
+            patch(next, here());
+        }
+        if (chain->conditions.size() == chain->bodys.size() - 1)
+            emit_scope(*chain->bodys.back());
+        for (int end : ends)
+            patch(end, here());
+
+    } else if (auto loop = dynamic_cast<For*>(statement.get())) {
+        const Scope& internal = *loop->internal_scope;
+        emit_expression(loop->initialization, internal, true);
+
+        int counted = -1;
+        if (loop->counted) {
+            chunk->loops.push_back(loop);
+            counted = (int)chunk->loops.size() - 1;
+        }
+
+        int begin = here();
+        int exit = -1;
+        if (counted != -1) {
+            exit = emit(OpCode::LoopTest, 0, counted);
+            begin = here();
+        } else if (loop->condition.operands.size()) {
+            emit_expression(loop->condition, internal, false);
+            exit = emit(OpCode::JumpIfFalse);
+        }
+        breaks.emplace_back();
+        emit_scope(*loop->body);
+        // a counted loop steps and tests its counter in one instruction that jumps back to the
+        // body, see For::next()
+        if (counted != -1) {
+            emit(OpCode::LoopNext, begin, counted);
+        } else {
+            emit_expression(loop->updation, internal, true);
+            emit(OpCode::Jump, begin);
+        }
+
+        if (exit != -1)
+            patch(exit, here());
+        for (int index : breaks.back())
+            patch(index, here());
+        breaks.pop_back();
+
+    } else if (auto loop = dynamic_cast<While*>(statement.get())) {
+        int begin = here();
+        emit_expression(loop->condition, scope, false);
+        int exit = emit(OpCode::JumpIfFalse);
+        breaks.emplace_back();
+        emit_scope(*loop->body);
+        emit(OpCode::Jump, begin);
+
+        patch(exit, here());
+        for (int index : breaks.back())
+            patch(index, here());
+        breaks.pop_back();
+
+    } else if (auto block = dynamic_cast<Scope*>(statement.get())) {
+        emit_scope(*block);
+
+    } else {
+        chunk->statements.push_back({statement, &scope});
+        emit(OpCode::Run, (int)chunk->statements.size() - 1);
+    }
+}
+
+void BytecodeCompiler::emit_expression(const Expression& expression, const Scope& scope,
+                                       bool discard) {
+    if (expression.operands.size() == 0) {
+        LLC_CHECK(discard);
+        return;
+    }
+    LLC_CHECK(expression.operands.size() == 1);
+    emit_operand(expression.operands[0], scope, discard);
+}
+
+void BytecodeCompiler::emit_operand(const std::shared_ptr<Operand>& operand, const Scope& scope,
+                                    bool discard) {
+    Operand* op = operand.get();
+
+    auto variable_of = [&](const std::shared_ptr<Operand>& target) -> int {
+        auto variable = dynamic_cast<VariableOp*>(target.get());
+        if (variable == nullptr)
+            return -1;
+        return variable->ref ? add_variable(variable->ref) : -1;
+    };
+
+    auto binary = [&](BinaryOp* binary, OpCode code) {
+        emit_operand(binary->a, scope, false);
+        emit_operand(binary->b, scope, false);
+        emit(code);
+        if (discard)
+            emit(OpCode::Pop);
+    };
+
+    auto compound = [&](BinaryOp* binary, OpCode code) {
+        int variable = variable_of(binary->a);
+        if (variable == -1)
+            return emit_fallback(operand, scope, discard);
+        emit_operand(binary->b, scope, false);
+        emit(code, variable);
+        if (!discard)
+            emit(OpCode::Load, variable);
+    };
+
+    if (auto literal = dynamic_cast<NumberLiteral*>(op)) {
+        if (!discard)
+            emit(OpCode::Constant, add_constant(literal->value));
+
+    } else if (auto literal = dynamic_cast<CharLiteral*>(op)) {
+        if (!discard)
+            emit(OpCode::Constant, add_constant(Object(literal->value)));
+
+    } else if (auto literal = dynamic_cast<StringLiteral*>(op)) {
+        if (!discard)
+            emit(OpCode::Constant, add_constant(Object(literal->value)));
+
+    } else if (dynamic_cast<VariableOp*>(op)) {
+        int variable = variable_of(operand);
+        if (variable == -1)
+            return emit_fallback(operand, scope, discard);
+        if (!discard)
+            emit(OpCode::Load, variable);
+
+    } else if (auto assignment = dynamic_cast<Assignment*>(op)) {
+        int variable = variable_of(assignment->a);
+        if (variable == -1)
+            return emit_fallback(operand, scope, discard);
+        emit_operand(assignment->b, scope, false);
+        emit(OpCode::Store, variable);
+        if (!discard)
+            emit(OpCode::Load, variable);
+
+    } else if (auto add = dynamic_cast<Addition*>(op)) {
+        binary(add, OpCode::Add);
+    } else if (auto sub = dynamic_cast<Subtrbody*>(op)) {
+        binary(sub, OpCode::Subtract);
+    } else if (auto mul = dynamic_cast<Multiplication*>(op)) {
+        binary(mul, OpCode::Multiply);
+    } else if (auto div = dynamic_cast<Division*>(op)) {
+        binary(div, OpCode::Divide);
+    } else if (auto lt = dynamic_cast<LessThan*>(op)) {
+        binary(lt, OpCode::LessThan);
+    } else if (auto le = dynamic_cast<LessEqual*>(op)) {
+        binary(le, OpCode::LessEqual);
+    } else if (auto gt = dynamic_cast<GreaterThan*>(op)) {
+        binary(gt, OpCode::GreaterThan);
+    } else if (auto ge = dynamic_cast<GreaterEqual*>(op)) {
+        binary(ge, OpCode::GreaterEqual);
+    } else if (auto eq = dynamic_cast<Equal*>(op)) {
+        binary(eq, OpCode::Equal);
+    } else if (auto ne = dynamic_cast<NotEqual*>(op)) {
+        binary(ne, OpCode::NotEqual);
+
+    } else if (auto add = dynamic_cast<AddEqual*>(op)) {
+        compound(add, OpCode::AddEqual);
+    } else if (auto sub = dynamic_cast<SubtractEqual*>(op)) {
+        compound(sub, OpCode::SubtractEqual);
+    } else if (auto mul = dynamic_cast<MultiplyEqual*>(op)) {
+        compound(mul, OpCode::MultiplyEqual);
+    } else if (auto div = dynamic_cast<DivideEqual*>(op)) {
+        compound(div, OpCode::DivideEqual);
+
+    } else if (auto negation = dynamic_cast<Negation*>(op)) {
+        emit_operand(negation->operand, scope, false);
+        emit(OpCode::Negate);
+        if (discard)
+            emit(OpCode::Pop);
+
+    } else if (dynamic_cast<PreIncrement*>(op) || dynamic_cast<PreDecrement*>(op)) {
+        int variable = variable_of(static_cast<PreUnaryOp*>(op)->operand);
+        if (variable == -1)
+            return emit_fallback(operand, scope, discard);
+        emit(dynamic_cast<PreIncrement*>(op) ? OpCode::Increment : OpCode::Decrement, variable);
+        if (!discard)
+            emit(OpCode::Load, variable);
+
+    } else if (dynamic_cast<PostIncrement*>(op) || dynamic_cast<PostDecrement*>(op)) {
+        int variable = variable_of(static_cast<PostUnaryOp*>(op)->operand);
+        if (variable == -1)
+            return emit_fallback(operand, scope, discard);
+        if (!discard)
+            emit(OpCode::Load, variable);
+        emit(dynamic_cast<PostIncrement*>(op) ? OpCode::Increment : OpCode::Decrement, variable);
+
+    } else if (auto call = dynamic_cast<FunctionCallOp*>(op)) {
+        const Function* function = scope.find_function(call->function.function_name);
+        if (function == nullptr)
+            return emit_fallback(operand, scope, discard);
+        for (const auto& argument : call->function.arguments)
+            emit_expression(argument, scope, false);
+        emit(OpCode::Call, add_function(function, scope), (int)call->function.arguments.size());
+        if (discard)
+            emit(OpCode::Pop);
+
+    } else {
+        emit_fallback(operand, scope, discard);
+    }
+}
+
+void BytecodeCompiler::emit_fallback(const std::shared_ptr<Operand>& operand, const Scope& scope,
+                                     bool discard) {
+    chunk->operands.push_back({operand, &scope});
+    emit(OpCode::Evaluate, (int)chunk->operands.size() - 1);
+    if (discard)
+        emit(OpCode::Pop);
+}
+
+int BytecodeCompiler::emit(OpCode op, int a, int b) {
+    switch (op) {
+    case OpCode::Constant:
+    case OpCode::Load:
+    case OpCode::Evaluate: depth++; break;
+    case OpCode::Call: depth += 1 - b; break;
+    case OpCode::TailCall: depth -= b; break;
+    case OpCode::Negate:
+    case OpCode::Increment:
+    case OpCode::Decrement:
+    case OpCode::Run:
+    case OpCode::LoopTest:
+    case OpCode::LoopNext:
+    case OpCode::Jump:
+    case OpCode::ReturnVoid: break;
+    default: depth--; break;
+    }
+    LLC_CHECK(depth >= 0);
+    chunk->max_stack = std::max(chunk->max_stack, depth);
+
+    chunk->code.push_back({op, a, b});
+    return (int)chunk->code.size() - 1;
+}
+
+void BytecodeCompiler::patch(int index, int target) {
+    LLC_CHECK(index >= 0 && index < (int)chunk->code.size());
+    chunk->code[index].a = target;
+}
+
+int BytecodeCompiler::add_constant(Object object) {
+    chunk->constants.push_back(object);
+    return (int)chunk->constants.size() - 1;
+}
+
+int BytecodeCompiler::add_variable(const VariableRef& variable) {
+    auto it = std::find(chunk->variables.begin(), chunk->variables.end(), variable);
+    if (it != chunk->variables.end())
+        return int(it - chunk->variables.begin());
+    chunk->variables.push_back(variable);
+    return (int)chunk->variables.size() - 1;
+}
+
+int BytecodeCompiler::add_function(const Function* function, const Scope& scope) {
+    chunk->functions.push_back({function, &scope});
+    return (int)chunk->functions.size() - 1;
+}
+
+Completion Bytecode::run(const Scope&) const {
+    ScratchVector<Object> operands;
+    std::vector<Object>& stack = operands.values;
+    stack.reserve(chunk.max_stack);
+
+    const Instruction* code = chunk.code.data();
+    const Instruction* pc = code;
+
+    while (true) {
+        const Instruction& instruction = *pc++;
+
+        switch (instruction.op) {
+        case OpCode::Constant: stack.push_back(chunk.constants[instruction.a]); break;
+        case OpCode::Load: stack.push_back(chunk.variables[instruction.a].get()); break;
+        case OpCode::Store:
+            chunk.variables[instruction.a].get().assign(stack.back());
+            stack.pop_back();
+            break;
+        case OpCode::Pop: stack.pop_back(); break;
+
+        case OpCode::Add:
+            stack[stack.size() - 2] += stack.back();
+            stack.pop_back();
+            break;
+        case OpCode::Subtract:
+            stack[stack.size() - 2] -= stack.back();
+            stack.pop_back();
+            break;
+        case OpCode::Multiply:
+            stack[stack.size() - 2] *= stack.back();
+            stack.pop_back();
+            break;
+        case OpCode::Divide:
+            stack[stack.size() - 2] /= stack.back();
+            stack.pop_back();
+            break;
+        case OpCode::Negate: stack.back() = -stack.back(); break;
+
+        case OpCode::LessThan: {
+            bool result = stack[stack.size() - 2] < stack.back();
+            stack.pop_back();
+            stack.back() = Object(result);
+            break;
+        }
+        case OpCode::LessEqual: {
+            bool result = stack[stack.size() - 2] <= stack.back();
+            stack.pop_back();
+            stack.back() = Object(result);
+            break;
+        }
+        case OpCode::GreaterThan: {
+            bool result = stack[stack.size() - 2] > stack.back();
+            stack.pop_back();
+            stack.back() = Object(result);
+            break;
+        }
+        case OpCode::GreaterEqual: {
+            bool result = stack[stack.size() - 2] >= stack.back();
+            stack.pop_back();
+            stack.back() = Object(result);
+            break;
+        }
+        case OpCode::Equal: {
+            bool result = stack[stack.size() - 2] == stack.back();
+            stack.pop_back();
+            stack.back() = Object(result);
+            break;
+        }
+        case OpCode::NotEqual: {
+            bool result = stack[stack.size() - 2] != stack.back();
+            stack.pop_back();
+            stack.back() = Object(result);
+            break;
+        }
+
+        case OpCode::AddEqual:
+            chunk.variables[instruction.a].get() += stack.back();
+            stack.pop_back();
+            break;
+        case OpCode::SubtractEqual:
+            chunk.variables[instruction.a].get() -= stack.back();
+            stack.pop_back();
+            break;
+        case OpCode::MultiplyEqual:
+            chunk.variables[instruction.a].get() *= stack.back();
+            stack.pop_back();
+            break;
+        case OpCode::DivideEqual:
+            chunk.variables[instruction.a].get() /= stack.back();
+            stack.pop_back();
+            break;
+        case OpCode::Increment: ++chunk.variables[instruction.a].get(); break;
+        case OpCode::Decrement: --chunk.variables[instruction.a].get(); break;
+
+        case OpCode::Call: {
+            const auto& function = chunk.functions[instruction.a];
+            ScratchVector<Object> args;
+            for (int i = 0; i < instruction.b; i++)
+                args.values.push_back(std::move(stack[stack.size() - instruction.b + i]));
+            stack.resize(stack.size() - instruction.b);
+
+            if (auto result = function.first->call(*function.second, args.values))
+                stack.push_back(std::move(*result));
+            else
+                stack.emplace_back();
+            break;
+        }
+        case OpCode::Evaluate: {
+            const auto& operand = chunk.operands[instruction.a];
+            stack.push_back(operand.first->evaluate(*operand.second));
+            break;
+        }
+        case OpCode::Run: {
+            const auto& statement = chunk.statements[instruction.a];
+            Completion completion = statement.first->run(*statement.second);
+            if (completion.flow != Flow::Normal)
+                return completion;
+            break;
+        }
+
+        case OpCode::Jump: pc = code + instruction.a; break;
+        case OpCode::JumpIfFalse: {
+            bool condition = stack.back().as<bool>();
+            stack.pop_back();
+            if (!condition)
+                pc = code + instruction.a;
+            break;
+        }
+        case OpCode::LoopTest:
+            if (!chunk.loops[instruction.b]->test())
+                pc = code + instruction.a;
+            break;
+        case OpCode::LoopNext: {
+            if (chunk.loops[instruction.b]->next())
+                pc = code + instruction.a;
+            break;
+        }
+        case OpCode::Return: {
+            return {Flow::Return, std::move(stack.back())};
+        }
+        case OpCode::ReturnVoid: return {Flow::Return};
+        case OpCode::TailCall: {
+            Frame& frame = *Frame::current;
+            frame.tail_arguments.resize(instruction.b);
+            for (int i = 0; i < instruction.b; i++)
+                frame.tail_arguments[i] = std::move(stack[stack.size() - instruction.b + i]);
+            frame.tail_function = static_cast<const InternalFunction*>(
+                chunk.functions[instruction.a].first->base.get());
+            return {Flow::TailCall};
+        }
+        }
+    }
+}
+
+}  // namespace llc
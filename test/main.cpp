@@ -1,6 +1,7 @@
 #include <llc/compiler.h>
 #include <fstream>
 #include <chrono>
+#include <thread>
 
 using namespace llc;
 
@@ -90,6 +91,8 @@ void struct_test() {
 
         Number x;
         x.set(10);
+        Number y = x;
+        y.add(5);
     )";
 
         Compiler compiler;
@@ -97,6 +100,8 @@ void struct_test() {
         program.run();
 
         print("x = ", program["x"]["get"]().as<int>());
+        // a copy has fields of its own, so y = 15 and x is unchanged
+        print("y = ", program["y"]["get"]().as<int>());
 
         // call member function of struct defined inside program
         // x = 32
@@ -173,7 +178,8 @@ void dynamic_alloc_test() {
             }
 
             int n;
-            std::shared_ptr<int[]> ptr;
+            // owned by the heap of the program
+            int* ptr;
         };
 
         program.source = R"(
@@ -189,15 +195,19 @@ void dynamic_alloc_test() {
         compiler.compile(program);
         program.run();
 
+        // running again releases what the previous run allocated
+        program.run();
+        print("live heap bytes after two runs: ", program.heap_stats().live_bytes);
+
     } catch (const std::exception& exception) {
         print(exception.what());
     }
 }
 
-void mandelbrot_test() {
+void mandelbrot_test(Engine engine) {
     try {
         Program program;
-        program.bind<std::string>("string").ctor<int, char>().bind("size", &std::string::size);
+        program.bind<std::string>("string").ctor<int, char>().bind_pure("size", &std::string::size);
         program.bind("puts", print<std::string>);
 
         program.source = R"(
@@ -232,6 +242,7 @@ void mandelbrot_test() {
         )";
 
         Compiler compiler;
+        compiler.engine = engine;
         compiler.compile(program);
         program.run();
 
@@ -240,7 +251,7 @@ void mandelbrot_test() {
     }
 }
 
-void benchmark() {
+void benchmark(Engine engine, std::string name) {
     try {
         Program program;
 
@@ -252,6 +263,9 @@ void benchmark() {
         )";
 
         Compiler compiler;
+        compiler.engine = engine;
+        // the loop does nothing and would be removed, it is here to measure the loop itself
+        compiler.passes.disable("dead-code-elimination");
         compiler.compile(program);
 
         {
@@ -260,7 +274,7 @@ void benchmark() {
             auto end = std::chrono::high_resolution_clock::now();
             float ms = std::chrono::duration<float>(end - start).count() * 1e+3f;
             float ns = ms * 1e+6f;
-            print("100000 loop run in: ", ms, " ms, avg: ", ns / 100000, " ns / loop");
+            print(name, ": 100000 loop run in: ", ms, " ms, avg: ", ns / 100000, " ns / loop");
         }
 
     } catch (const std::exception& exception) {
@@ -268,14 +282,448 @@ void benchmark() {
     }
 }
 
+void recursion_benchmark(Engine engine, std::string name) {
+    try {
+        Program program;
+
+        program.source = R"(
+            int fibonacci_impl(int a, int b, int n){
+                if(n <= 0)
+                    return a;
+                else
+                    return fibonacci_impl(b, a + b, n - 1);
+            }
+
+            for(int i = 0; i < 1000; i++)
+                fibonacci_impl(0, 1, 25);
+        )";
+
+        Compiler compiler;
+        compiler.engine = engine;
+        compiler.jit = false;
+        compiler.compile(program);
+
+        auto start = std::chrono::high_resolution_clock::now();
+        program.run();
+        auto end = std::chrono::high_resolution_clock::now();
+        float ms = std::chrono::duration<float>(end - start).count() * 1e+3f;
+        float ns = ms * 1e+6f;
+        print(name, ": 26000 recursive calls in: ", ms, " ms, avg: ", ns / 26000, " ns / call, ",
+              program.last_run_clones / 26000.0f, " clones / call, ",
+              program.last_run_arena.leases / 26000.0f, " scratch vectors / call (",
+              program.last_run_arena.leases_reused, " reused)");
+
+    } catch (const std::exception& exception) {
+        print(exception.what());
+    }
+}
+
+void reentrancy_test(Engine engine, std::string name) {
+    try {
+        Program program;
+
+        program.source = R"(
+            int fibonacci(int n){
+                if(n < 2)
+                    return n;
+                return fibonacci(n - 1) + fibonacci(n - 2);
+            }
+        )";
+
+        Compiler compiler;
+        compiler.engine = engine;
+        compiler.jit = false;
+        compiler.compile(program);
+        program.run();
+
+        // every call has its own frame, so the same function can run on several threads at once
+        std::vector<int> results(4);
+        std::vector<std::thread> threads;
+        for (int i = 0; i < (int)results.size(); i++)
+            threads.emplace_back([&, i] { results[i] = program["fibonacci"](15 + i).as<int>(); });
+        for (auto& thread : threads)
+            thread.join();
+
+        print(name, ": fibonacci(15..18) = ", results[0], ' ', results[1], ' ', results[2], ' ',
+              results[3]);
+
+    } catch (const std::exception& exception) {
+        print(exception.what());
+    }
+}
+
+void tail_call_test(Engine engine, std::string name) {
+    try {
+        Program program;
+
+        program.source = R"(
+            int count(int n, int total){
+                if(n <= 0)
+                    return total;
+                return count(n - 1, total + 1);
+            }
+
+            int depth = count(1000000, 0);
+        )";
+
+        Compiler compiler;
+        compiler.engine = engine;
+        compiler.jit = false;
+        compiler.compile(program);
+        program.run();
+
+        // calls in tail position reuse the frame, so the depth is not bounded by the native stack
+        print(name, ": tail recursion depth = ", program["depth"].as<int>());
+
+    } catch (const std::exception& exception) {
+        print(exception.what());
+    }
+}
+
+void jit_test(bool jit, std::string name) {
+    try {
+        Program program;
+
+        program.source = R"(
+            int fibonacci_impl(int a, int b, int n){
+                if(n <= 0)
+                    return a;
+                else
+                    return fibonacci_impl(b, a + b, n - 1);
+            }
+
+            int escape(float cx, float cy){
+                float zx = 0.0f;
+                float zy = 0.0f;
+                int iter = 0;
+                for(;iter < 40; iter++){
+                    float nx = zx * zx - zy * zy + cx;
+                    float ny = 2.0f * zx * zy + cy;
+                    zx = nx;
+                    zy = ny;
+                    if(zx * zx + zy * zy > 4.0f)
+                        break;
+                }
+                return iter;
+            }
+
+            int total = 0;
+            for(int i = 0; i < 1000; i++)
+                total += fibonacci_impl(0, 1, 25);
+            for(float i = 0; i < 40; i++)
+                for(float j = 0; j < 80; j++)
+                    total += escape(j / (80.0f / 3.0f) - 1.5f, i / (40.0f / 3.0f) - 1.5f);
+        )";
+
+        Compiler compiler;
+        compiler.jit = jit;
+        compiler.compile(program);
+
+        auto start = std::chrono::high_resolution_clock::now();
+        program.run();
+        auto end = std::chrono::high_resolution_clock::now();
+        float ms = std::chrono::duration<float>(end - start).count() * 1e+3f;
+        print(name, ": total ", program["total"].as<int>(), " computed in: ", ms, " ms");
+
+    } catch (const std::exception& exception) {
+        print(exception.what());
+    }
+}
+
+void constant_folding_test(bool optimize, std::string name) {
+    try {
+        Program program;
+
+        program.source = R"(
+            float total = 0.0f;
+            for(int i = 0; i < 100000; i++){
+                float scale = 80.0f / 3.0f;
+                float offset = -1.5f;
+                total += i / scale + offset * (40.0f / 3.0f);
+            }
+        )";
+
+        Compiler compiler;
+        compiler.jit = false;
+        compiler.passes.enable("constant-folding", optimize);
+        compiler.passes.enable("constant-propagation", optimize);
+        compiler.compile(program);
+
+        auto start = std::chrono::high_resolution_clock::now();
+        program.run();
+        auto end = std::chrono::high_resolution_clock::now();
+        float ms = std::chrono::duration<float>(end - start).count() * 1e+3f;
+        print(name, ": total ", program["total"].as<float>(), " computed in: ", ms, " ms");
+
+    } catch (const std::exception& exception) {
+        print(exception.what());
+    }
+}
+
+void dead_code_test(Engine engine, std::string name) {
+    try {
+        Program program;
+
+        program.source = R"(
+            int ENABLE_FAST = 1;
+            int ENABLE_TRACE = 0;
+
+            int pick(int n){
+                if(ENABLE_TRACE)
+                    puts("tracing");
+                return n;
+                puts("unreachable");
+            }
+
+            int total = 0;
+            for(int i = 0; i < 100; i++){
+                if(ENABLE_TRACE)
+                    puts("tracing");
+                else if(ENABLE_FAST)
+                    total += pick(i);
+                else
+                    total -= i;
+            }
+            while(ENABLE_TRACE)
+                puts("tracing");
+        )";
+
+        program.bind("puts", print<std::string>);
+
+        Compiler compiler;
+        compiler.engine = engine;
+        compiler.compile(program);
+        program.run();
+        print(name, ": total with dead code removed = ", program["total"].as<int>());
+
+    } catch (const std::exception& exception) {
+        print(exception.what());
+    }
+}
+
+void counted_loop_test(Engine engine, std::string name) {
+    try {
+        Program program;
+
+        program.source = R"(
+            int count(int n){
+                int total = 0;
+                for(int i = 0; i < n; i++)
+                    total += i;
+                for(int i = n; i >= 0; i -= 3)
+                    total += 1;
+                for(int i = 0; i != 10; i += 2){
+                    if(i == 6)
+                        break;
+                    total += 100;
+                }
+                int limit = 5;
+                for(int i = 0; i < limit; ++i){
+                    limit = 3;
+                    total += 1000;
+                }
+                for(int i = 0; i <= 20; --i)
+                    i += 5;
+                for(float x = 0.0f; x < 2.0f; x += 0.5f)
+                    total += 10000;
+                for(int i = 0; i < 100; i++){
+                    if(i == 7)
+                        return total + i;
+                }
+                return 0;
+            }
+
+            int total = count(10);
+            int steps = 0;
+            for(int i = 0; i < 10; i++)
+                for(int j = i; j > 0; j--)
+                    steps++;
+        )";
+
+        Compiler compiler;
+        compiler.engine = engine;
+        compiler.jit = false;
+        compiler.compile(program);
+        program.run();
+        print(name, ": counted loops total = ", program["total"].as<int>(),
+              ", steps = ", program["steps"].as<int>());
+
+    } catch (const std::exception& exception) {
+        print(exception.what());
+    }
+}
+
+float square(float x) {
+    return x * x;
+}
+
+void loop_invariant_test(bool hoist, std::string name) {
+    try {
+        Program program;
+
+        program.source = R"(
+            float sum(float scale, int n){
+                float total = 0.0f;
+                for(int i = 0; i < n; i++)
+                    total += i / (scale * scale + 1.0f) + square(scale);
+                return total;
+            }
+
+            float total = sum(3.0f, 100000);
+        )";
+
+        program.bind_pure("square", square);
+
+        Compiler compiler;
+        compiler.jit = false;
+        compiler.passes.enable("loop-invariant-code-motion", hoist);
+        compiler.compile(program);
+
+        auto start = std::chrono::high_resolution_clock::now();
+        program.run();
+        auto end = std::chrono::high_resolution_clock::now();
+        float ms = std::chrono::duration<float>(end - start).count() * 1e+3f;
+        print(name, ": total ", program["total"].as<float>(), " computed in: ", ms, " ms");
+
+    } catch (const std::exception& exception) {
+        print(exception.what());
+    }
+}
+
+void ir_test() {
+    try {
+        Program program;
+
+        program.source = R"(
+            int clamp(int x, int low, int high){
+                int debug = 0;
+                int step = 2 * 3;
+                int limit = high - step + step;
+                if(debug)
+                    x = 0;
+                if(x < low)
+                    return low;
+                if(x > limit)
+                    return limit;
+                return x;
+            }
+
+            int triangle(int n){
+                int total = 0;
+                for(int i = 1; i <= n; ++i){
+                    int scaled = i * 2;
+                    total += scaled / 2 + i * 2 - scaled;
+                }
+                return total;
+            }
+        )";
+
+        Compiler compiler;
+        compiler.jit = false;
+        compiler.compile(program);
+        program.run();
+
+        for (const auto& function : compiler.lower(program)) {
+            if (function.name == "triangle")
+                print(ir::print(function));
+            for (int n : {-5, 3, 50}) {
+                std::vector<Object> args = {Object(n)};
+                if (function.name == "clamp")
+                    args = {Object(n), Object(0), Object(10)};
+                int expected = function.name == "clamp" ? program["clamp"](n, 0, 10).as<int>()
+                                                        : program["triangle"](n).as<int>();
+                int result = ir::run(function, args)->as<int>();
+                print("ir ", function.name, "(", n, ") = ", result,
+                      result == expected ? "" : " differs from the interpreter");
+            }
+        }
+
+    } catch (const std::exception& exception) {
+        print(exception.what());
+    }
+}
+
+void inlining_test(int threshold, std::string name) {
+    try {
+        Program program;
+
+        program.source = R"(
+            struct Number{
+                void set(int n){
+                    number = n;
+                }
+                int get(){
+                    return number;
+                }
+
+                int number;
+            };
+
+            int twice(int x){
+                return x * 2;
+            }
+            float half(float x){
+                return x / 2;
+            }
+
+            Number counter;
+            int total = 0;
+            for(int i = 0; i < 100000; i++){
+                counter.set(i);
+                total += twice(counter.get()) - half(i * 2) * 2 + 1;
+            }
+        )";
+
+        Compiler compiler;
+        compiler.jit = false;
+        compiler.passes.get<Inlining>().threshold = threshold;
+        compiler.compile(program);
+
+        auto start = std::chrono::high_resolution_clock::now();
+        program.run();
+        auto end = std::chrono::high_resolution_clock::now();
+        float ms = std::chrono::duration<float>(end - start).count() * 1e+3f;
+        print(name, ": total ", program["total"].as<int>(), " computed in: ", ms, " ms");
+
+    } catch (const std::exception& exception) {
+        print(exception.what());
+    }
+}
+
 int main() {
     minimal_test();
     function_test();
     struct_test();
     ctor_test();
     dynamic_alloc_test();
-    mandelbrot_test();
-    benchmark();
+    mandelbrot_test(Engine::Bytecode);
+    benchmark(Engine::TreeWalker, "tree walker");
+    benchmark(Engine::Bytecode, "bytecode");
+    benchmark(Engine::Closure, "closure");
+    recursion_benchmark(Engine::TreeWalker, "tree walker");
+    recursion_benchmark(Engine::Bytecode, "bytecode");
+    recursion_benchmark(Engine::Closure, "closure");
+    reentrancy_test(Engine::TreeWalker, "tree walker");
+    reentrancy_test(Engine::Bytecode, "bytecode");
+    reentrancy_test(Engine::Closure, "closure");
+    tail_call_test(Engine::TreeWalker, "tree walker");
+    tail_call_test(Engine::Bytecode, "bytecode");
+    tail_call_test(Engine::Closure, "closure");
+    jit_test(false, "interpreter");
+    jit_test(true, "jit");
+    constant_folding_test(false, "unfolded");
+    constant_folding_test(true, "folded");
+    dead_code_test(Engine::TreeWalker, "tree walker");
+    dead_code_test(Engine::Bytecode, "bytecode");
+    dead_code_test(Engine::Closure, "closure");
+    loop_invariant_test(false, "in loop");
+    loop_invariant_test(true, "hoisted");
+    ir_test();
+    inlining_test(0, "called");
+    inlining_test(16, "inlined");
+    counted_loop_test(Engine::TreeWalker, "tree walker");
+    counted_loop_test(Engine::Bytecode, "bytecode");
+    counted_loop_test(Engine::Closure, "closure");
 
     return 0;
 }
\ No newline at end of file